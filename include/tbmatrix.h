@@ -0,0 +1,344 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tbmatrix.h
+//
+// Булева верхнетреугольная матрица, упакованная по битам: 64 элемента
+// в слове вместо байта (bool) или четырех байтов (int) на элемент.
+// Хранит отношения и смежность графов: элемент (i, j), i <= j - есть ли
+// связь i -> j.
+//
+// Строка i занимает слова с номерами от i / 64 до W - 1, W = (N + 63) / 64,
+// то есть выровнена по абсолютному номеру столбца: бит j % 64 слова j / 64
+// строки - элемент (i, j). Биты левее диагонали и правее N нулевые. Строки
+// лежат подряд в одном буфере, начало строки i вычисляется за O(1).
+// Выравнивание по столбцам позволяет объединять строки разной длины
+// пословно без сдвигов: логические операции, произведение и замыкание -
+// циклы по словам, которые компилятор векторизует.
+
+#ifndef __TBMATRIX_H__
+#define __TBMATRIX_H__
+
+#include "utmatrix.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+typedef unsigned long long TBitWord;
+const int BIT_WORD = 64; // бит в слове
+
+inline int BitCount(TBitWord x) // число единичных битов
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline int LowBit(TBitWord x) // номер младшего единичного бита, x != 0
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long k;
+	_BitScanForward64(&k, x);
+	return (int)k;
+#else
+	int k = 0;
+	while (!(x & 1))
+	{
+		x >>= 1;
+		k++;
+	}
+	return k;
+#endif
+}
+
+// Булева верхнетреугольная матрица
+class TBitMatrix
+{
+protected:
+	TIndex N;              // порядок
+	TIndex W;              // слов в строке 0
+	TVector<TBitWord> Data; // строки подряд
+	TIndex Offset(TIndex i) const // начало строки i в Data
+	{
+		const TIndex q = i / BIT_WORD;
+		return i * W - BIT_WORD * q * (q - 1) / 2 - (i % BIT_WORD) * q;
+	}
+public:
+	TBitMatrix(TIndex s = 10);
+	TIndex GetSize() const { return N; }
+	TIndex RowWords(TIndex i) const { return W - i / BIT_WORD; } // слов в строке i
+	TBitWord* Row(TIndex i) { return Data.Get_pVector() + Offset(i); } // слово 0 - столбцы от i - i % 64
+	const TBitWord* Row(TIndex i) const { return Data.Get_pVector() + Offset(i); }
+	bool operator()(TIndex i, TIndex j) const;   // элемент; ниже диагонали - false
+	void Set(TIndex i, TIndex j, bool v = true); // записать элемент (i, j), i <= j
+	TIndex RowCount(TIndex i) const;             // единиц в строке i
+	TIndex Count() const;                        // единиц в матрице
+	TVector<TIndex> Degrees() const;             // степени вершин неориентированного графа
+	bool operator==(const TBitMatrix& m) const { return N == m.N && Data == m.Data; }
+	bool operator!=(const TBitMatrix& m) const { return !(*this == m); }
+
+	// логические операции
+	TBitMatrix operator&(const TBitMatrix& m) const;
+	TBitMatrix operator|(const TBitMatrix& m) const;
+	TBitMatrix operator^(const TBitMatrix& m) const;
+	TBitMatrix& operator&=(const TBitMatrix& m);
+	TBitMatrix& operator|=(const TBitMatrix& m);
+	TBitMatrix& operator^=(const TBitMatrix& m);
+	TBitMatrix operator*(const TBitMatrix& m) const; // булево произведение
+	TBitMatrix Closure() const;                      // транзитивное замыкание
+
+	// преобразование: ненулевые элементы - единицы
+	template <class T> explicit TBitMatrix(const TMatrix<T>& m);
+	template <class T> void ToMatrix(TMatrix<T>& m) const;
+
+	// ввод-вывод
+	friend ostream& operator<<(ostream& out, const TBitMatrix& m)
+	{
+		for (TIndex i = 0; i < m.N; i++)
+		{
+			for (TIndex j = 0; j < i; j++)
+				out << "  ";
+			for (TIndex j = i; j < m.N; j++)
+				out << m(i, j) << ' ';
+			out << endl;
+		}
+		return out;
+	}
+};
+
+inline TBitMatrix::TBitMatrix(TIndex s) : N(s), W((s > 0) ? (s + BIT_WORD - 1) / BIT_WORD : 0), Data(0)
+{
+	if (s < 0 || s > MaxMatrixSize())
+		throw "wrong size";
+	Data = TVector<TBitWord>(Offset(N));
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+TBitMatrix::TBitMatrix(const TMatrix<T>& m) : N(m.GetSize()), W((m.GetSize() + BIT_WORD - 1) / BIT_WORD), Data(0)
+{
+	Data = TVector<TBitWord>(Offset(N));
+	TBitWord* p = Data.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < N; i++)
+	{
+		const T* src = m.Row(i).Get_pVector();
+		TBitWord* row = p + Offset(i);
+		const TIndex b = i % BIT_WORD;
+		for (TIndex j = 0; j < N - i; j++)
+			if (src[j] != T(0))
+				row[(b + j) / BIT_WORD] |= TBitWord(1) << ((b + j) % BIT_WORD);
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // единицы и нули в m
+void TBitMatrix::ToMatrix(TMatrix<T>& m) const
+{
+	m = TMatrix<T>(N);
+	TVector<T>* rows = m.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < N; i++)
+	{
+		T* dst = rows[i].Get_pVector();
+		const TBitWord* row = Row(i);
+		const TIndex b = i % BIT_WORD;
+		for (TIndex j = 0; j < N - i; j++)
+			dst[j] = ((row[(b + j) / BIT_WORD] >> ((b + j) % BIT_WORD)) & 1) ? T(1) : T(0);
+	}
+} /*-------------------------------------------------------------------------*/
+
+inline bool TBitMatrix::operator()(TIndex i, TIndex j) const
+{
+	if (i < 0 || j < 0 || i >= N || j >= N)
+		throw "bad index";
+	if (j < i)
+		return false;
+	return (Row(i)[j / BIT_WORD - i / BIT_WORD] >> (j % BIT_WORD)) & 1;
+} /*-------------------------------------------------------------------------*/
+
+inline void TBitMatrix::Set(TIndex i, TIndex j, bool v)
+{
+	if (i < 0 || j >= N || j < i)
+		throw "bad index";
+	TBitWord& w = Row(i)[j / BIT_WORD - i / BIT_WORD];
+	const TBitWord bit = TBitWord(1) << (j % BIT_WORD);
+	w = v ? (w | bit) : (w & ~bit);
+} /*-------------------------------------------------------------------------*/
+
+inline TIndex TBitMatrix::RowCount(TIndex i) const
+{
+	if (i < 0 || i >= N)
+		throw "bad index";
+	const TBitWord* row = Row(i);
+	TIndex s = 0;
+	for (TIndex w = 0; w < RowWords(i); w++)
+		s += BitCount(row[w]);
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+inline TIndex TBitMatrix::Count() const
+{
+	const TBitWord* p = Data.Get_pVector();
+	const TIndex n = Data.GetSize();
+	TIndex s = 0;
+#pragma omp parallel for reduction(+: s) schedule(static)
+	for (TIndex w = 0; w < n; w++)
+		s += BitCount(p[w]);
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+// Степень вершины i - число ее связей: единицы строки i (связи с j >= i)
+// плюс единицы столбца i выше диагонали (связи с k < i); петля считается
+// один раз. Столбцы собираются обходом единичных битов.
+inline TVector<TIndex> TBitMatrix::Degrees() const
+{
+	TVector<TIndex> deg(N);
+	TIndex* pd = deg.Get_pVector();
+	for (TIndex i = 0; i < N; i++)
+	{
+		const TBitWord* row = Row(i);
+		const TIndex j0 = i - i % BIT_WORD;
+		for (TIndex w = 0; w < RowWords(i); w++)
+		{
+			TBitWord x = row[w];
+			pd[i] += BitCount(x);
+			if (w == 0)
+				x &= ~(TBitWord(1) << (i % BIT_WORD)); // петля уже учтена
+			while (x)
+			{
+				pd[j0 + w * BIT_WORD + LowBit(x)]++;
+				x &= x - 1;
+			}
+		}
+	}
+	return deg;
+} /*-------------------------------------------------------------------------*/
+
+inline TBitMatrix& TBitMatrix::operator&=(const TBitMatrix& m)
+{
+	if (N != m.N)
+		throw "not equal size";
+	TBitWord* RESTRICT p = Data.Get_pVector();
+	const TBitWord* RESTRICT q = m.Data.Get_pVector();
+	const TIndex n = Data.GetSize();
+#pragma omp parallel for schedule(static)
+	for (TIndex w = 0; w < n; w++)
+		p[w] &= q[w];
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+inline TBitMatrix& TBitMatrix::operator|=(const TBitMatrix& m)
+{
+	if (N != m.N)
+		throw "not equal size";
+	TBitWord* RESTRICT p = Data.Get_pVector();
+	const TBitWord* RESTRICT q = m.Data.Get_pVector();
+	const TIndex n = Data.GetSize();
+#pragma omp parallel for schedule(static)
+	for (TIndex w = 0; w < n; w++)
+		p[w] |= q[w];
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+inline TBitMatrix& TBitMatrix::operator^=(const TBitMatrix& m)
+{
+	if (N != m.N)
+		throw "not equal size";
+	TBitWord* RESTRICT p = Data.Get_pVector();
+	const TBitWord* RESTRICT q = m.Data.Get_pVector();
+	const TIndex n = Data.GetSize();
+#pragma omp parallel for schedule(static)
+	for (TIndex w = 0; w < n; w++)
+		p[w] ^= q[w];
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+inline TBitMatrix TBitMatrix::operator&(const TBitMatrix& m) const
+{
+	TBitMatrix res(*this);
+	return res &= m;
+} /*-------------------------------------------------------------------------*/
+
+inline TBitMatrix TBitMatrix::operator|(const TBitMatrix& m) const
+{
+	TBitMatrix res(*this);
+	return res |= m;
+} /*-------------------------------------------------------------------------*/
+
+inline TBitMatrix TBitMatrix::operator^(const TBitMatrix& m) const
+{
+	TBitMatrix res(*this);
+	return res ^= m;
+} /*-------------------------------------------------------------------------*/
+
+// Булево произведение: строка i результата - объединение строк k матрицы m
+// по единицам (i, k) строки i. Строка k начинается со слова k / 64, и в
+// строке i это слово с номером k / 64 - i / 64: объединение идет без сдвигов.
+inline TBitMatrix TBitMatrix::operator*(const TBitMatrix& m) const
+{
+	if (N != m.N)
+		throw "not equal size";
+	TBitMatrix res(N);
+	TBitWord* pr = res.Data.Get_pVector(); // буфер результата отделяется до параллельной части
+#pragma omp parallel for schedule(dynamic, ROW_BAND)
+	for (TIndex i = 0; i < N; i++)
+	{
+		const TBitWord* a = Row(i);
+		TBitWord* RESTRICT c = pr + Offset(i);
+		const TIndex wi = i / BIT_WORD;
+		for (TIndex w = 0; w < RowWords(i); w++)
+		{
+			TBitWord x = a[w];
+			while (x)
+			{
+				const TIndex k = (wi + w) * BIT_WORD + LowBit(x);
+				const TBitWord* RESTRICT b = m.Row(k);
+				TBitWord* ck = c + (k / BIT_WORD - wi);
+				for (TIndex v = 0; v < m.RowWords(k); v++)
+					ck[v] |= b[v];
+				x &= x - 1;
+			}
+		}
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+// Транзитивное замыкание отношения i -> j, i <= j: строки обрабатываются
+// снизу вверх, к строке i добавляются уже замкнутые строки k > i по
+// единицам исходной строки i. Строки зависят друг от друга, поэтому проход
+// последовательный; объединение строк - пословное.
+inline TBitMatrix TBitMatrix::Closure() const
+{
+	TBitMatrix res(*this);
+	TBitWord* orig = new TBitWord[W + 1];
+	for (TIndex i = N - 1; i >= 0; i--)
+	{
+		TBitWord* c = res.Row(i);
+		const TIndex wi = i / BIT_WORD, nw = RowWords(i);
+		for (TIndex w = 0; w < nw; w++)
+			orig[w] = c[w];
+		orig[0] &= ~(TBitWord(1) << (i % BIT_WORD)); // петля не добавляет связей
+		for (TIndex w = 0; w < nw; w++)
+		{
+			TBitWord x = orig[w];
+			while (x)
+			{
+				const TIndex k = (wi + w) * BIT_WORD + LowBit(x);
+				const TBitWord* RESTRICT b = res.Row(k);
+				TBitWord* RESTRICT ck = c + (k / BIT_WORD - wi);
+				for (TIndex v = 0; v < RowWords(k); v++)
+					ck[v] |= b[v];
+				x &= x - 1;
+			}
+		}
+	}
+	delete[] orig;
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+#endif
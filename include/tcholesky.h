@@ -0,0 +1,215 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tcholesky.h
+//
+// Разложение Холецкого симметричной положительно определенной матрицы:
+// A = U^T U, U - верхнетреугольная TMatrix. Строка i хранилища A
+// превращается в строку i множителя U на месте.
+//
+// CholeskyBlocked - правостороннее блочное разложение: полоса из CHOL_BLOCK
+//   строк раскладывается последовательно (диагональный блок и решение
+//   системы для блоков справа), затем оставшиеся строки обновляются
+//   параллельно: U[i][c] -= сумма по k полосы U[k][i] * U[k][c].
+// CholeskyTasks - та же работа, разбитая на плитки CHOL_BLOCK x CHOL_BLOCK
+//   и запущенная задачами OpenMP с зависимостями по плиткам: обновление
+//   плитки начинается, как только готовы нужные ей плитки полосы, не
+//   дожидаясь конца всей полосы. Требуется OpenMP 4.0 (depend); иначе
+//   (в том числе в MSVC, где OpenMP 2.0) выполняется CholeskyBlocked.
+//
+// Неположительный ведущий элемент не исключение: номер и значение первого
+// такого элемента возвращаются в TCholeskyInfo; после CholeskyBlocked строки
+// выше него - готовые строки U. Cholesky(a) без отчета бросает
+// "not positive definite".
+
+#ifndef __TCHOLESKY_H__
+#define __TCHOLESKY_H__
+
+#include "tsmatrix.h"
+
+const int CHOL_BLOCK = 64;          // строк в полосе (сторона плитки)
+const TIndex CHOL_TASK_MIN = 1024;  // порядок, начиная с которого Cholesky использует задачи
+
+// Отчет о разложении
+struct TCholeskyInfo
+{
+	TIndex Pivot; // номер первого неположительного ведущего элемента, -1 - разложение выполнено
+	double Value; // значение этого элемента после исключения предыдущих строк
+	bool Ok() const { return Pivot < 0; }
+};
+
+// Ядра над строками r[i] (r[i][c - i] - элемент (i, c)); полоса - строки [k0, k1).
+
+template <class T> // диагональный блок полосы и столбцы [k1, c1): возвращает номер отказа или -1
+TIndex CholPanel(T** r, TIndex k0, TIndex k1, TIndex c1, double& value)
+{
+	for (TIndex k = k0; k < k1; k++)
+	{
+		T* rk = r[k];
+		if (!(rk[0] > T(0)))
+		{
+			value = (double)rk[0];
+			return k;
+		}
+		const T d = (T)sqrt((double)rk[0]);
+		rk[0] = d;
+		for (TIndex c = 1; c < c1 - k; c++)
+			rk[c] /= d;
+		for (TIndex i = k + 1; i < k1; i++)
+		{
+			T* ri = r[i];
+			const T* rki = rk + (i - k); // rki[c - i] - элемент (k, c)
+			const T a = rki[0];
+			for (TIndex c = 0; c < c1 - i; c++)
+				ri[c] -= a * rki[c];
+		}
+	}
+	return -1;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // столбцы [c0, c1) строк полосы по готовому диагональному блоку
+void CholSolve(T** r, TIndex k0, TIndex k1, TIndex c0, TIndex c1)
+{
+	for (TIndex k = k0; k < k1; k++)
+	{
+		T* rk = r[k] + (c0 - k);
+		const T d = r[k][0];
+		for (TIndex c = 0; c < c1 - c0; c++)
+			rk[c] /= d;
+		for (TIndex i = k + 1; i < k1; i++)
+		{
+			T* ri = r[i] + (c0 - i);
+			const T a = r[k][i - k];
+			for (TIndex c = 0; c < c1 - c0; c++)
+				ri[c] -= a * rk[c];
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// строка i, столбцы [c0, c1), c0 >= i: вычитание вклада строк полосы,
+// по четыре строки за проход по строке i
+template <class T>
+void CholUpdateRow(T** r, TIndex k0, TIndex k1, TIndex i, TIndex c0, TIndex c1)
+{
+	T* RESTRICT ri = r[i] + (c0 - i);
+	const TIndex len = c1 - c0;
+	TIndex k = k0;
+	for (; k + 4 <= k1; k += 4)
+	{
+		const T* RESTRICT r0 = r[k] + (c0 - k);
+		const T* RESTRICT r1 = r[k + 1] + (c0 - k - 1);
+		const T* RESTRICT r2 = r[k + 2] + (c0 - k - 2);
+		const T* RESTRICT r3 = r[k + 3] + (c0 - k - 3);
+		const T a0 = r[k][i - k], a1 = r[k + 1][i - k - 1];
+		const T a2 = r[k + 2][i - k - 2], a3 = r[k + 3][i - k - 3];
+		for (TIndex c = 0; c < len; c++)
+			ri[c] -= (a0 * r0[c] + a1 * r1[c]) + (a2 * r2[c] + a3 * r3[c]);
+	}
+	for (; k < k1; k++)
+	{
+		const T* RESTRICT rk = r[k] + (c0 - k);
+		const T a = r[k][i - k];
+		for (TIndex c = 0; c < len; c++)
+			ri[c] -= a * rk[c];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // U = A (копия верхнего треугольника) и таблица строк U
+T** CholRows(const TSymMatrix<T>& a, TMatrix<T>& u)
+{
+	const TIndex n = a.GetSize();
+	u = a.Upper();
+	TVector<T>* rows = u.Get_pVector();
+	T** r = new T*[n];
+	for (TIndex i = 0; i < n; i++)
+		r[i] = rows[i].Get_pVector(); // разделяемые строки отделяются до параллельной части
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // правостороннее блочное разложение
+TCholeskyInfo CholeskyBlocked(const TSymMatrix<T>& a, TMatrix<T>& u)
+{
+	const TIndex n = a.GetSize();
+	T** r = CholRows(a, u);
+	TCholeskyInfo info = { -1, 0 };
+	for (TIndex k0 = 0; k0 < n && info.Ok(); k0 += CHOL_BLOCK)
+	{
+		const TIndex k1 = (k0 + CHOL_BLOCK < n) ? k0 + CHOL_BLOCK : n;
+		info.Pivot = CholPanel(r, k0, k1, n, info.Value);
+		if (!info.Ok())
+			break;
+#pragma omp parallel for schedule(static, ROW_BAND)
+		for (TIndex i = k1; i < n; i++)
+			CholUpdateRow(r, k0, k1, i, i, n);
+	}
+	delete[] r;
+	return info;
+} /*-------------------------------------------------------------------------*/
+
+// Разложение задачами по плиткам (I, J), I <= J - строки полосы I, столбцы полосы J.
+// На шаге K: разложение (K, K); решение (K, J), J > K; обновление (I, J), K < I <= J.
+// Зависимости задаются адресами элементов tile[I * nb + J].
+template <class T>
+TCholeskyInfo CholeskyTasks(const TSymMatrix<T>& a, TMatrix<T>& u)
+{
+#if defined(_OPENMP) && _OPENMP >= 201307
+	const TIndex n = a.GetSize();
+	const TIndex nb = (n + CHOL_BLOCK - 1) / CHOL_BLOCK;
+	T** r = CholRows(a, u);
+	char* tile = new char[nb * nb + 1];
+	TCholeskyInfo info = { -1, 0 };
+	atomic<bool> failed(false); // после отказа оставшиеся задачи ничего не делают
+#pragma omp parallel
+#pragma omp single
+	for (TIndex K = 0; K < nb; K++)
+	{
+		const TIndex k0 = K * CHOL_BLOCK, k1 = (k0 + CHOL_BLOCK < n) ? k0 + CHOL_BLOCK : n;
+#pragma omp task depend(inout: tile[K * nb + K]) shared(info, failed)
+		if (!failed.load(memory_order_relaxed))
+		{
+			info.Pivot = CholPanel(r, k0, k1, k1, info.Value);
+			failed.store(!info.Ok(), memory_order_relaxed);
+		}
+		for (TIndex J = K + 1; J < nb; J++)
+		{
+			const TIndex c0 = J * CHOL_BLOCK, c1 = (c0 + CHOL_BLOCK < n) ? c0 + CHOL_BLOCK : n;
+#pragma omp task depend(in: tile[K * nb + K]) depend(inout: tile[K * nb + J]) shared(failed)
+			if (!failed.load(memory_order_relaxed))
+				CholSolve(r, k0, k1, c0, c1);
+		}
+		for (TIndex I = K + 1; I < nb; I++)
+			for (TIndex J = I; J < nb; J++)
+			{
+				const TIndex i0 = I * CHOL_BLOCK, i1 = (i0 + CHOL_BLOCK < n) ? i0 + CHOL_BLOCK : n;
+				const TIndex c0 = J * CHOL_BLOCK, c1 = (c0 + CHOL_BLOCK < n) ? c0 + CHOL_BLOCK : n;
+#pragma omp task depend(in: tile[K * nb + I], tile[K * nb + J]) depend(inout: tile[I * nb + J]) shared(failed)
+				if (!failed.load(memory_order_relaxed))
+					for (TIndex i = i0; i < i1; i++)
+						CholUpdateRow(r, k0, k1, i, (i > c0) ? i : c0, c1);
+			}
+	}
+	delete[] tile;
+	delete[] r;
+	return info;
+#else
+	return CholeskyBlocked(a, u);
+#endif
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // разложение с отчетом; вариант выбирается по порядку
+TCholeskyInfo Cholesky(const TSymMatrix<T>& a, TMatrix<T>& u)
+{
+	if (a.GetSize() >= CHOL_TASK_MIN)
+		return CholeskyTasks(a, u);
+	return CholeskyBlocked(a, u);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // U, A = U^T U
+TMatrix<T> Cholesky(const TSymMatrix<T>& a)
+{
+	TMatrix<T> u(0);
+	if (!Cholesky(a, u).Ok())
+		throw "not positive definite";
+	return u;
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,151 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tcmatrix.h
+//
+// Строго верхнетреугольная матрица в сжатом хранилище: элементы (i, j),
+// j > i, лежат построчно в одном буфере из N (N - 1) / 2 элементов,
+// диагональ не хранится и равна общему значению Diag (0 - расстояния,
+// смежность; 1 - сравнения, корреляции). Ниже диагонали - нули, как
+// у TMatrix.
+//
+// Номер элемента: k(i, j) = i (2N - i - 1) / 2 + (j - i - 1), строка i -
+// непрерывный отрезок длины N - i - 1, начиная с k(i, i + 1). По сравнению
+// с TMatrix нет N диагональных элементов и N объектов строк с их буферами.
+
+#ifndef __TCMATRIX_H__
+#define __TCMATRIX_H__
+
+#include "utmatrix.h"
+
+// Строго верхнетреугольная матрица
+template <class T>
+class TCondensedMatrix
+{
+protected:
+	TIndex N;        // порядок
+	T Diag;          // значение диагонали
+	TVector<T> Data; // строки над диагональю подряд
+	static TIndex Elements(TIndex s); // N (N - 1) / 2 с проверкой порядка
+public:
+	TCondensedMatrix(TIndex s = 10, T diag = 0);
+	explicit TCondensedMatrix(const TMatrix<T>& m, T diag = 0); // элементы m над диагональю
+	TIndex GetSize() const { return N; }
+	T GetDiagonal() const { return Diag; }
+	static TIndex Index(TIndex n, TIndex i, TIndex j) // номер элемента (i, j), i < j
+	{
+		return i * (2 * n - i - 1) / 2 + (j - i - 1);
+	}
+	T* Row(TIndex i) { return Data.Get_pVector() + Index(N, i, i + 1); }         // (i, i + 1..N)
+	const T* Row(TIndex i) const { return Data.Get_pVector() + Index(N, i, i + 1); }
+	T& operator()(TIndex i, TIndex j);       // доступ, j > i
+	T operator()(TIndex i, TIndex j) const;  // Diag на диагонали, ноль ниже
+	TMatrix<T> ToMatrix() const;             // полное хранилище TMatrix
+	bool operator==(const TCondensedMatrix& m) const { return N == m.N && Diag == m.Diag && Data == m.Data; }
+	bool operator!=(const TCondensedMatrix& m) const { return !(*this == m); }
+
+	// ввод-вывод
+	friend ostream& operator<<(ostream& out, const TCondensedMatrix& m)
+	{
+		for (TIndex i = 0; i < m.N; i++)
+		{
+			for (TIndex j = 0; j < i; j++)
+				out << "  ";
+			for (TIndex j = i; j < m.N; j++)
+				out << m(i, j) << ' ';
+			out << endl;
+		}
+		return out;
+	}
+};
+
+template <class T>
+TIndex TCondensedMatrix<T>::Elements(TIndex s)
+{
+	// хранилище - один TVector, поэтому предел - MaxVectorSize() элементов,
+	// а не MaxMatrixSize(): порядок может быть больше, чем у TMatrix
+	if (s < 0 || (s > 1 && s - 1 > 2 * MaxVectorSize() / s)) // без переполнения s (s - 1)
+		throw "wrong size";
+	return (s > 0) ? s * (s - 1) / 2 : 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+TCondensedMatrix<T>::TCondensedMatrix(TIndex s, T diag) : N(s), Diag(diag), Data(Elements(s))
+{
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+TCondensedMatrix<T>::TCondensedMatrix(const TMatrix<T>& m, T diag) : N(m.GetSize()), Diag(diag),
+	Data(Elements(m.GetSize()))
+{
+	T* p = Data.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < N; i++)
+	{
+		const T* src = m.Row(i).Get_pVector() + 1;
+		T* dst = p + Index(N, i, i + 1);
+		for (TIndex j = 0; j < N - i - 1; j++)
+			dst[j] = src[j];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+T& TCondensedMatrix<T>::operator()(TIndex i, TIndex j)
+{
+	if (i < 0 || j >= N || j <= i)
+		throw "bad index";
+	return Data[Index(N, i, j)];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+T TCondensedMatrix<T>::operator()(TIndex i, TIndex j) const
+{
+	if (i < 0 || j < 0 || i >= N || j >= N)
+		throw "bad index";
+	if (i == j)
+		return Diag;
+	return (j > i) ? Data[Index(N, i, j)] : T(0);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // полное хранилище; диагональ 0 или 1 отмечается признаком TDiagonal
+TMatrix<T> TCondensedMatrix<T>::ToMatrix() const
+{
+	TMatrix<T> m(N);
+	TVector<T>* rows = m.Get_pVector();
+	const T* p = Data.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < N; i++)
+	{
+		T* dst = rows[i].Get_pVector();
+		const T* src = p + Index(N, i, i + 1);
+		dst[0] = Diag;
+		for (TIndex j = 0; j < N - i - 1; j++)
+			dst[j + 1] = src[j];
+	}
+	if (Diag == T(0))
+		m.SetDiagonal(DIAG_ZERO);
+	else if (Diag == T(1))
+		m.SetDiagonal(DIAG_UNIT);
+	return m;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // A * x: строки без диагонали, диагональ - Diag * x
+TVector<T> MatVec(const TCondensedMatrix<T>& a, const TVector<T>& x)
+{
+	const TIndex n = a.GetSize();
+	if (x.GetSize() != n)
+		throw "not equal size";
+	TVector<T> y(n);
+	T* py = y.Get_pVector();
+	const T* px = x.Get_pVector();
+	const T d = a.GetDiagonal();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		py[i] = VecDot(a.Row(i), px + i + 1, n - i - 1);
+		if (d != T(0))
+			py[i] += d * px[i];
+	}
+	return y;
+} /*-------------------------------------------------------------------------*/
+
+#endif
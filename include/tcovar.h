@@ -0,0 +1,204 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tcovar.h
+//
+// Накопление выборочного среднего и ковариации потока векторов.
+//
+// Наблюдения копируются в пакет из COV_BATCH строк; заполненный пакет
+// центрируется по своему среднему и добавляется к сумме центрированных
+// произведений M2 одним обновлением ранга k (Syrk), затем состояние
+// сдвигается к общему среднему поправкой ранга 1 (формула Чана):
+//   delta = mean_b - mean,  M2 += M2_b + delta delta^T n n_b / (n + n_b).
+// Вычитание средних до умножения сохраняет точность при больших средних
+// (как у Велфорда), а пакеты превращают N^2 обновлений ранга 1 в одно SYRK.
+//
+// Состояния, накопленные отдельно (например, по потокам), объединяются
+// Merge за O(N^2) той же формулой.
+
+#ifndef __TCOVAR_H__
+#define __TCOVAR_H__
+
+#include "tsmatrix.h"
+
+const TIndex COV_BATCH = 128; // наблюдений в пакете
+
+// Накопитель ковариации
+template <class T>
+class TCovariance
+{
+protected:
+	TIndex Count;           // учтенных наблюдений (без пакета)
+	TVector<T> Mean;        // их среднее
+	TMatrix<T> M2;          // сумма (x - Mean)(x - Mean)^T, верхний треугольник
+	TDenseMatrix<T> Batch;  // пакет, строка - наблюдение
+	TIndex BatchCount;      // наблюдений в пакете
+	void Combine(TIndex n, const T* mean); // сдвиг к общему среднему с группой из n наблюдений
+public:
+	TCovariance(TIndex s = 10);
+	TIndex GetSize() const { return Mean.GetSize(); }
+	TIndex GetCount() const { return Count + BatchCount; } // число наблюдений
+	void Add(const TVector<T>& x);        // добавить наблюдение
+	void Flush();                         // учесть пакет
+	void Merge(const TCovariance& c);     // добавить наблюдения, учтенные в c
+	const TVector<T>& GetMean();          // среднее
+	TMatrix<T> Covariance(TIndex ddof = 1); // M2 / (число - ddof)
+	TMatrix<T> Correlation();             // корреляция; при нулевой дисперсии - NaN
+};
+
+template <class T>
+TCovariance<T>::TCovariance(TIndex s) : Count(0), Mean(s), M2(s), Batch(COV_BATCH, s), BatchCount(0)
+{
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // добавить наблюдение
+void TCovariance<T>::Add(const TVector<T>& x)
+{
+	if (x.GetSize() != GetSize())
+		throw "not equal size";
+	const T* px = x.Get_pVector();
+	T* row = Batch.Get_pMem() + BatchCount * GetSize();
+	for (TIndex j = 0; j < GetSize(); j++)
+		row[j] = px[j];
+	if (++BatchCount == COV_BATCH)
+		Flush();
+} /*-------------------------------------------------------------------------*/
+
+// M2 += delta delta^T n Count / (Count + n), Mean += delta n / (Count + n),
+// delta = mean - Mean; M2 группы уже добавлена
+template <class T>
+void TCovariance<T>::Combine(TIndex n, const T* mean)
+{
+	const TIndex s = GetSize();
+	TVector<T> delta(s);
+	T* pd = delta.Get_pVector();
+	T* pm = Mean.Get_pVector();
+	for (TIndex j = 0; j < s; j++)
+		pd[j] = mean[j] - pm[j];
+	const T w = (T)((double)Count * n / (Count + n));
+	TVector<T>* rows = M2.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < s; i++)
+	{
+		T* ri = rows[i].Get_pVector();
+		const T wdi = w * pd[i];
+		for (TIndex j = 0; j < s - i; j++)
+			ri[j] += wdi * pd[i + j];
+	}
+	const T f = (T)((double)n / (Count + n));
+	for (TIndex j = 0; j < s; j++)
+		pm[j] += f * pd[j];
+	Count += n;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // учесть пакет: центрирование, SYRK, поправка ранга 1
+void TCovariance<T>::Flush()
+{
+	if (BatchCount == 0)
+		return;
+	const TIndex s = GetSize();
+	T* pb = Batch.Get_pMem();
+	TVector<T> mean(s);
+	T* pm = mean.Get_pVector();
+	for (TIndex r = 0; r < BatchCount; r++)
+		for (TIndex j = 0; j < s; j++)
+			pm[j] += pb[r * s + j];
+	for (TIndex j = 0; j < s; j++)
+		pm[j] /= (T)BatchCount;
+	for (TIndex r = 0; r < BatchCount; r++)
+		for (TIndex j = 0; j < s; j++)
+			pb[r * s + j] -= pm[j];
+	Syrk(M2, Batch); // строки за BatchCount нулевые
+	Combine(BatchCount, pm);
+	for (TIndex l = 0; l < BatchCount * s; l++)
+		pb[l] = 0;
+	BatchCount = 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // добавить наблюдения, учтенные в c
+void TCovariance<T>::Merge(const TCovariance<T>& c)
+{
+	if (c.GetSize() != GetSize())
+		throw "not equal size";
+	if (&c == this) // c.Merge(c): операнд меняется по ходу слияния
+	{
+		const TCovariance<T> copy(c);
+		Merge(copy);
+		return;
+	}
+	if (c.Count > 0)
+	{
+		TVector<T>* rows = M2.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < GetSize(); i++)
+		{
+			T* ri = rows[i].Get_pVector();
+			const T* ci = c.M2.Row(i).Get_pVector();
+			for (TIndex j = 0; j < GetSize() - i; j++)
+				ri[j] += ci[j];
+		}
+		Combine(c.Count, c.Mean.Get_pVector());
+	}
+	const T* pb = c.Batch.Get_pMem();
+	for (TIndex r = 0; r < c.BatchCount; r++)
+	{
+		T* row = Batch.Get_pMem() + BatchCount * GetSize();
+		for (TIndex j = 0; j < GetSize(); j++)
+			row[j] = pb[r * GetSize() + j];
+		if (++BatchCount == COV_BATCH)
+			Flush();
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // среднее
+const TVector<T>& TCovariance<T>::GetMean()
+{
+	Flush();
+	return Mean;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // M2 / (число - ddof)
+TMatrix<T> TCovariance<T>::Covariance(TIndex ddof)
+{
+	Flush();
+	if (Count <= ddof)
+		throw "empty vector";
+	TMatrix<T> res(M2);
+	const T f = T(1) / (T)(Count - ddof);
+	TVector<T>* rows = res.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < GetSize(); i++)
+	{
+		T* ri = rows[i].Get_pVector();
+		for (TIndex j = 0; j < GetSize() - i; j++)
+			ri[j] *= f;
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // корреляция
+TMatrix<T> TCovariance<T>::Correlation()
+{
+	Flush();
+	if (Count == 0)
+		throw "empty vector";
+	const TIndex s = GetSize();
+	TVector<T> scale(s);
+	T* ps = scale.Get_pVector();
+	for (TIndex i = 0; i < s; i++)
+	{
+		const T d = M2.Row(i).Get_pVector()[0];
+		ps[i] = (d > T(0)) ? T(1) / (T)sqrt((double)d) : numeric_limits<T>::quiet_NaN();
+	}
+	TMatrix<T> res(M2);
+	TVector<T>* rows = res.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < s; i++)
+	{
+		T* ri = rows[i].Get_pVector();
+		for (TIndex j = 0; j < s - i; j++)
+			ri[j] *= ps[i] * ps[i + j];
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+#endif
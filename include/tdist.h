@@ -0,0 +1,181 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tdist.h
+//
+// Матрица попарных расстояний между точками - строками плотной матрицы X
+// (N x d). Матрица симметрична с нулевой диагональю, поэтому хранится
+// верхний треугольник TMatrix порядка N или только элементы над
+// диагональю в TCondensedMatrix.
+//
+// Евклидово и косинусное расстояния выражаются через матрицу Грама
+// G = X X^T: |x - y|^2 = |x|^2 + |y|^2 - 2 x.y, cos = x.y / (|x| |y|).
+// Элементы G над диагональю вычисляются блочным ядром SYRK (SyrkRows над
+// X^T без копии), нормы |x|^2 - отдельным проходом по X в том же порядке
+// суммирования, затем строки G преобразуются в расстояния. Манхэттенское расстояние
+// скалярным произведением не выражается и считается по плиткам
+// DIST_BLOCK x DIST_BLOCK точек: строки плитки столбцов остаются в кеше,
+// пока по ним проходят строки плитки строк.
+// Треугольная работа делится динамически по полосам строк: полосы
+// убывают по длине, и свободный поток берет следующую.
+
+#ifndef __TDIST_H__
+#define __TDIST_H__
+
+#include "tsmatrix.h"
+#include "tcmatrix.h"
+
+// Расстояние
+enum TDistance { DIST_EUCLIDEAN, DIST_SQEUCLIDEAN, DIST_COSINE, DIST_MANHATTAN };
+
+const TIndex DIST_BLOCK = 64; // точек в плитке (манхэттенское расстояние)
+
+template <class T> // сумма |a[i] - b[i]|
+T VecL1Distance(const T* a, const T* b, TIndex n)
+{
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		s0 += Abs(a[i] - b[i]);
+		s1 += Abs(a[i + 1] - b[i + 1]);
+		s2 += Abs(a[i + 2] - b[i + 2]);
+		s3 += Abs(a[i + 3] - b[i + 3]);
+	}
+	for (; i < n; i++)
+		s0 += Abs(a[i] - b[i]);
+	return (s0 + s1) + (s2 + s3);
+} /*-------------------------------------------------------------------------*/
+
+// манхэттенские расстояния по плиткам; элемент (i, j) - pd[i][j - i - off],
+// при off = 0 диагональ обнуляется
+template <class T>
+void L1Distances(const TDenseMatrix<T>& x, T** pd, TIndex off)
+{
+	const TIndex n = x.GetRows(), d = x.GetCols();
+	const TIndex nb = (n + DIST_BLOCK - 1) / DIST_BLOCK;
+	// строки в порядке ROW_MAJOR, чтобы ядро шло по координатам подряд
+	TDenseMatrix<T> rowx(x.GetOrder() == ROW_MAJOR ? 0 : n, x.GetOrder() == ROW_MAJOR ? 0 : d);
+	if (x.GetOrder() != ROW_MAJOR)
+		for (TIndex i = 0; i < n; i++)
+			for (TIndex j = 0; j < d; j++)
+				rowx(i, j) = x(i, j);
+	const T* px = (x.GetOrder() == ROW_MAJOR) ? x.Get_pMem() : rowx.Get_pMem();
+#pragma omp parallel for schedule(dynamic, 1)
+	for (TIndex bi = 0; bi < nb; bi++)
+	{
+		const TIndex i0 = bi * DIST_BLOCK, i1 = (i0 + DIST_BLOCK < n) ? i0 + DIST_BLOCK : n;
+		for (TIndex j0 = i0; j0 < n; j0 += DIST_BLOCK)
+		{
+			const TIndex j1 = (j0 + DIST_BLOCK < n) ? j0 + DIST_BLOCK : n;
+			for (TIndex i = i0; i < i1; i++)
+			{
+				const T* xi = px + i * d;
+				for (TIndex j = (j0 > i) ? j0 : i + 1; j < j1; j++)
+					pd[i][j - i - off] = VecL1Distance(xi, px + j * d, d);
+			}
+		}
+		if (off == 0)
+			for (TIndex i = i0; i < i1; i++)
+				pd[i][0] = 0;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // |x_i|^2 порциями по SYRK_KC координат, как в SyrkRows
+void SquaredNorms(const TDenseMatrix<T>& x, T* pn)
+{
+	const TIndex n = x.GetRows(), d = x.GetCols();
+	const TIndex rs = x.RowStride(), cs = x.ColStride();
+	const T* px = x.Get_pMem();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		T s = 0;
+		for (TIndex r0 = 0; r0 < d; r0 += SYRK_KC)
+		{
+			const TIndex r1 = (r0 + SYRK_KC < d) ? r0 + SYRK_KC : d;
+			T acc = 0;
+			for (TIndex r = r0; r < r1; r++)
+				acc += px[i * rs + r * cs] * px[i * rs + r * cs];
+			s += acc;
+		}
+		pn[i] = s;
+	}
+} /*-------------------------------------------------------------------------*/
+
+// расстояния между строками x: элемент (i, j), j > i - pd[i][j - i - off];
+// при off = 0 диагональ pd[i][0] обнуляется
+template <class T>
+void DistanceRows(const TDenseMatrix<T>& x, T** pd, TIndex off, TDistance metric)
+{
+	const TIndex n = x.GetRows();
+	if (metric == DIST_MANHATTAN)
+	{
+		L1Distances(x, pd, off);
+		return;
+	}
+	// G = X X^T над диагональю: X^T - матрица d x N с переставленными шагами
+	SyrkRows(pd, n, off, x.Get_pMem(), x.GetCols(), x.ColStride(), x.RowStride(), T(1), T(1));
+	TVector<T> norm(n);
+	T* pn = norm.Get_pVector();
+	SquaredNorms(x, pn);
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		T* di = pd[i]; // di[j - i - off] - элемент (i, j)
+		const T* nj = pn + i;
+		if (metric == DIST_COSINE)
+		{
+			const T ri = (T)sqrt((double)nj[0]);
+			for (TIndex j = 1; j < n - i; j++)
+			{
+				const T r = ri * (T)sqrt((double)nj[j]);
+				di[j - off] = (r > T(0)) ? T(1) - di[j - off] / r : numeric_limits<T>::quiet_NaN();
+			}
+		}
+		else
+			for (TIndex j = 1; j < n - i; j++)
+			{
+				T s = nj[0] + nj[j] - T(2) * di[j - off];
+				s = (s > T(0)) ? s : T(0); // отрицательное - погрешность округления
+				di[j - off] = (metric == DIST_EUCLIDEAN) ? (T)sqrt((double)s) : s;
+			}
+		if (off == 0)
+			di[0] = 0;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // расстояния между строками x в верхний треугольник dist
+void Distances(const TDenseMatrix<T>& x, TMatrix<T>& dist, TDistance metric = DIST_EUCLIDEAN)
+{
+	const TIndex n = x.GetRows();
+	dist = TMatrix<T>(n);
+	TVector<T>* rows = dist.Get_pVector();
+	T** pd = new T*[n];
+	for (TIndex i = 0; i < n; i++)
+		pd[i] = rows[i].Get_pVector();
+	DistanceRows(x, pd, 0, metric);
+	delete[] pd;
+	dist.SetDiagonal(DIAG_ZERO);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // расстояния между строками x в сжатое хранилище без диагонали
+void Distances(const TDenseMatrix<T>& x, TCondensedMatrix<T>& dist, TDistance metric = DIST_EUCLIDEAN)
+{
+	const TIndex n = x.GetRows();
+	dist = TCondensedMatrix<T>(n);
+	T** pd = new T*[n];
+	for (TIndex i = 0; i < n; i++)
+		pd[i] = dist.Row(i);
+	DistanceRows(x, pd, 1, metric);
+	delete[] pd;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // матрица расстояний
+TMatrix<T> Distances(const TDenseMatrix<T>& x, TDistance metric = DIST_EUCLIDEAN)
+{
+	TMatrix<T> dist(0);
+	Distances(x, dist, metric);
+	return dist;
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,397 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tdmatrix.h
+//
+// Плотная прямоугольная матрица и операции треугольной матрицы с ней:
+//   TRMM: U * B, B^T * U
+//   TRSM: U^(-1) * B
+
+#ifndef __TDMATRIX_H__
+#define __TDMATRIX_H__
+
+#include "utmatrix.h"
+
+// Порядок хранения плотной матрицы
+enum TStorageOrder { ROW_MAJOR, COL_MAJOR };
+
+// Плотная прямоугольная матрица
+template <class T>
+class TDenseMatrix
+{
+protected:
+	T* pMem;
+	TIndex Rows;            // число строк
+	TIndex Cols;            // число столбцов
+	TStorageOrder Order; // порядок хранения
+public:
+	TDenseMatrix(TIndex r = 10, TIndex c = 10, TStorageOrder ord = ROW_MAJOR);
+	TDenseMatrix(const TDenseMatrix& m);          // копирование
+	~TDenseMatrix();
+	T* Get_pMem() { return pMem; }
+	const T* Get_pMem() const { return pMem; }
+	TIndex GetRows() const { return Rows; }
+	TIndex GetCols() const { return Cols; }
+	TStorageOrder GetOrder() const { return Order; }
+	// шаг между соседними строками и соседними столбцами в памяти
+	TIndex RowStride() const { return Order == ROW_MAJOR ? Cols : 1; }
+	TIndex ColStride() const { return Order == ROW_MAJOR ? 1 : Rows; }
+	T& operator()(TIndex i, TIndex j);                  // доступ
+	const T& operator()(TIndex i, TIndex j) const;
+	bool operator==(const TDenseMatrix& m) const; // сравнение
+	bool operator!=(const TDenseMatrix& m) const; // сравнение
+	TDenseMatrix& operator=(const TDenseMatrix& m); // присваивание
+
+	// ввод-вывод
+	friend istream& operator>>(istream& in, TDenseMatrix& m)
+	{
+		for (TIndex i = 0; i < m.Rows; i++)
+			for (TIndex j = 0; j < m.Cols; j++)
+				in >> m(i, j);
+		return in;
+	}
+	friend ostream& operator<<(ostream& out, const TDenseMatrix& m)
+	{
+		for (TIndex i = 0; i < m.Rows; i++)
+		{
+			for (TIndex j = 0; j < m.Cols; j++)
+				out << m(i, j) << ' ';
+			out << endl;
+		}
+		return out;
+	}
+};
+
+template <class T>
+TDenseMatrix<T>::TDenseMatrix(TIndex r, TIndex c, TStorageOrder ord)
+{
+	if (r < 0 || c < 0 || (c > 0 && r > MaxVectorSize() / c)) // r * c без переполнения
+		throw "wrong size";
+	Rows = r;
+	Cols = c;
+	Order = ord;
+	pMem = new T[Rows * Cols];
+	for (TIndex i = 0; i < Rows * Cols; i++)
+	{
+		pMem[i] = 0;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // конструктор копирования
+TDenseMatrix<T>::TDenseMatrix(const TDenseMatrix<T>& m)
+{
+	Rows = m.Rows;
+	Cols = m.Cols;
+	Order = m.Order;
+	pMem = new T[Rows * Cols];
+	for (TIndex i = 0; i < Rows * Cols; i++)
+	{
+		pMem[i] = m.pMem[i];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+TDenseMatrix<T>::~TDenseMatrix()
+{
+	delete[] pMem;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+T& TDenseMatrix<T>::operator()(TIndex i, TIndex j)
+{
+	if (i < 0 || i >= Rows || j < 0 || j >= Cols)
+		throw "bad index";
+	return pMem[i * RowStride() + j * ColStride()];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+const T& TDenseMatrix<T>::operator()(TIndex i, TIndex j) const
+{
+	if (i < 0 || i >= Rows || j < 0 || j >= Cols)
+		throw "bad index";
+	return pMem[i * RowStride() + j * ColStride()];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сравнение (порядок хранения не учитывается)
+bool TDenseMatrix<T>::operator==(const TDenseMatrix<T>& m) const
+{
+	if (Rows != m.Rows || Cols != m.Cols)
+		return false;
+	for (TIndex i = 0; i < Rows; i++)
+		for (TIndex j = 0; j < Cols; j++)
+			if ((*this)(i, j) != m(i, j))
+				return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сравнение
+bool TDenseMatrix<T>::operator!=(const TDenseMatrix<T>& m) const
+{
+	return !(*this == m);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // присваивание
+TDenseMatrix<T>& TDenseMatrix<T>::operator=(const TDenseMatrix<T>& m)
+{
+	if (this == &m)
+		return *this;
+	if (Rows * Cols != m.Rows * m.Cols)
+	{
+		delete[] pMem;
+		pMem = new T[m.Rows * m.Cols];
+	}
+	Rows = m.Rows;
+	Cols = m.Cols;
+	Order = m.Order;
+	for (TIndex i = 0; i < Rows * Cols; i++)
+	{
+		pMem[i] = m.pMem[i];
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+
+// Ядра TRMM/TRSM. Столбцы B обрабатываются блоками по TRI_BLOCK_COLS:
+// каждый элемент U читается один раз на блок, частичные суммы блока
+// держатся в локальных переменных. Нулевой треугольник U не читается.
+// Блоки столбцов независимы и распределяются между потоками (OpenMP).
+// Диагональ с признаком DIAG_UNIT или DIAG_ZERO не читается: вместо нее
+// подставляется 1 или 0.
+
+const int TRI_BLOCK_COLS = 4;
+
+// указатели на строки U: u[i][k - i] == U[i][k], k >= i
+template <class T>
+void TriRows(const TMatrix<T>& U, const T** u)
+{
+	for (TIndex i = 0; i < U.GetSize(); i++)
+		u[i] = U.Row(i).Get_pVector();
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // X = U * B
+TDenseMatrix<T> TRMM(const TMatrix<T>& U, const TDenseMatrix<T>& B)
+{
+	const TIndex n = U.GetSize();
+	if (B.GetRows() != n)
+		throw "not equal size";
+	const TIndex m = B.GetCols();
+	TDenseMatrix<T> X(n, m, B.GetOrder());
+	const T** u = new const T*[n];
+	TriRows(U, u);
+	const T* b = B.Get_pMem();
+	T* x = X.Get_pMem();
+	const TIndex rs = B.RowStride(), cs = B.ColStride();
+	const TIndex nb = (m + TRI_BLOCK_COLS - 1) / TRI_BLOCK_COLS;
+	const TIndex skip = (U.GetDiagonal() == DIAG_STORED) ? 0 : 1; // диагональ не читается
+	const T d = (U.GetDiagonal() == DIAG_UNIT) ? T(1) : T(0);    // ее значение при skip = 1
+
+#pragma omp parallel for schedule(static)
+	for (TIndex jb = 0; jb < nb; jb++)
+	{
+		const TIndex j = jb * TRI_BLOCK_COLS;
+		if (j + TRI_BLOCK_COLS <= m)
+		{
+			const T* b0 = b + j * cs;
+			const T* b1 = b0 + cs;
+			const T* b2 = b1 + cs;
+			const T* b3 = b2 + cs;
+			for (TIndex i = 0; i < n; i++)
+			{
+				const T* ui = u[i];
+				T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+				if (skip)
+				{
+					s0 = d * b0[i * rs];
+					s1 = d * b1[i * rs];
+					s2 = d * b2[i * rs];
+					s3 = d * b3[i * rs];
+				}
+				for (TIndex k = i + skip; k < n; k++)
+				{
+					const T uik = ui[k - i];
+					s0 += uik * b0[k * rs];
+					s1 += uik * b1[k * rs];
+					s2 += uik * b2[k * rs];
+					s3 += uik * b3[k * rs];
+				}
+				T* xi = x + i * rs + j * cs;
+				xi[0] = s0;
+				xi[cs] = s1;
+				xi[2 * cs] = s2;
+				xi[3 * cs] = s3;
+			}
+		}
+		else
+		{
+			for (TIndex jj = j; jj < m; jj++)
+			{
+				const T* bj = b + jj * cs;
+				for (TIndex i = 0; i < n; i++)
+				{
+					const T* ui = u[i];
+					T s = skip ? d * bj[i * rs] : T(0);
+					for (TIndex k = i + skip; k < n; k++)
+						s += ui[k - i] * bj[k * rs];
+					x[i * rs + jj * cs] = s;
+				}
+			}
+		}
+	}
+	delete[] u;
+	return X;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // X = B^T * U
+TDenseMatrix<T> TRMMTrans(const TDenseMatrix<T>& B, const TMatrix<T>& U)
+{
+	const TIndex n = U.GetSize();
+	if (B.GetRows() != n)
+		throw "not equal size";
+	const TIndex m = B.GetCols();
+	TDenseMatrix<T> X(m, n, B.GetOrder());
+	const T** u = new const T*[n];
+	TriRows(U, u);
+	const T* b = B.Get_pMem();
+	T* x = X.Get_pMem();
+	const TIndex rs = B.RowStride(), cs = B.ColStride();
+	const TIndex xrs = X.RowStride(), xcs = X.ColStride();
+	const TIndex nb = (m + TRI_BLOCK_COLS - 1) / TRI_BLOCK_COLS;
+	const TIndex skip = (U.GetDiagonal() == DIAG_STORED) ? 0 : 1; // диагональ не читается
+	const T d = (U.GetDiagonal() == DIAG_UNIT) ? T(1) : T(0);    // ее значение при skip = 1
+
+	// X[j][c] = sum(k <= c) B[k][j] * U[k][c]: строка k матрицы U
+	// прибавляется к строкам X, начиная со столбца k
+#pragma omp parallel for schedule(static)
+	for (TIndex jb = 0; jb < nb; jb++)
+	{
+		const TIndex j = jb * TRI_BLOCK_COLS;
+		const TIndex jend = (j + TRI_BLOCK_COLS <= m) ? j + TRI_BLOCK_COLS : m;
+		if (jend - j == TRI_BLOCK_COLS)
+		{
+			T* x0 = x + j * xrs;
+			T* x1 = x0 + xrs;
+			T* x2 = x1 + xrs;
+			T* x3 = x2 + xrs;
+			for (TIndex k = 0; k < n; k++)
+			{
+				const T* uk = u[k];
+				const T* bk = b + k * rs + j * cs;
+				const T a0 = bk[0], a1 = bk[cs], a2 = bk[2 * cs], a3 = bk[3 * cs];
+				if (skip)
+				{
+					x0[k * xcs] += a0 * d;
+					x1[k * xcs] += a1 * d;
+					x2[k * xcs] += a2 * d;
+					x3[k * xcs] += a3 * d;
+				}
+				for (TIndex c = k + skip; c < n; c++)
+				{
+					const T ukc = uk[c - k];
+					x0[c * xcs] += a0 * ukc;
+					x1[c * xcs] += a1 * ukc;
+					x2[c * xcs] += a2 * ukc;
+					x3[c * xcs] += a3 * ukc;
+				}
+			}
+		}
+		else
+		{
+			for (TIndex jj = j; jj < jend; jj++)
+			{
+				T* xj = x + jj * xrs;
+				for (TIndex k = 0; k < n; k++)
+				{
+					const T* uk = u[k];
+					const T a = b[k * rs + jj * cs];
+					if (skip)
+						xj[k * xcs] += a * d;
+					for (TIndex c = k + skip; c < n; c++)
+						xj[c * xcs] += a * uk[c - k];
+				}
+			}
+		}
+	}
+	delete[] u;
+	return X;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // X = U^(-1) * B (обратная подстановка)
+TDenseMatrix<T> TRSM(const TMatrix<T>& U, const TDenseMatrix<T>& B)
+{
+	const TIndex n = U.GetSize();
+	if (B.GetRows() != n)
+		throw "not equal size";
+	const TIndex m = B.GetCols();
+	const T** u = new const T*[n];
+	TriRows(U, u);
+	const bool unit = U.GetDiagonal() == DIAG_UNIT; // без деления
+	for (TIndex i = 0; i < n && !unit; i++)
+	{
+		if (U.GetDiagonal() == DIAG_ZERO || u[i][0] == T(0))
+		{
+			delete[] u;
+			throw "singular matrix";
+		}
+	}
+	TDenseMatrix<T> X(B);
+	T* x = X.Get_pMem();
+	const TIndex rs = X.RowStride(), cs = X.ColStride();
+	const TIndex nb = (m + TRI_BLOCK_COLS - 1) / TRI_BLOCK_COLS;
+
+#pragma omp parallel for schedule(static)
+	for (TIndex jb = 0; jb < nb; jb++)
+	{
+		const TIndex j = jb * TRI_BLOCK_COLS;
+		if (j + TRI_BLOCK_COLS <= m)
+		{
+			T* x0 = x + j * cs;
+			T* x1 = x0 + cs;
+			T* x2 = x1 + cs;
+			T* x3 = x2 + cs;
+			for (TIndex i = n - 1; i >= 0; i--)
+			{
+				const T* ui = u[i];
+				T s0 = x0[i * rs], s1 = x1[i * rs], s2 = x2[i * rs], s3 = x3[i * rs];
+				for (TIndex k = i + 1; k < n; k++)
+				{
+					const T uik = ui[k - i];
+					s0 -= uik * x0[k * rs];
+					s1 -= uik * x1[k * rs];
+					s2 -= uik * x2[k * rs];
+					s3 -= uik * x3[k * rs];
+				}
+				if (unit)
+				{
+					x0[i * rs] = s0;
+					x1[i * rs] = s1;
+					x2[i * rs] = s2;
+					x3[i * rs] = s3;
+					continue;
+				}
+				const T d = ui[0];
+				x0[i * rs] = s0 / d;
+				x1[i * rs] = s1 / d;
+				x2[i * rs] = s2 / d;
+				x3[i * rs] = s3 / d;
+			}
+		}
+		else
+		{
+			for (TIndex jj = j; jj < m; jj++)
+			{
+				T* xj = x + jj * cs;
+				for (TIndex i = n - 1; i >= 0; i--)
+				{
+					const T* ui = u[i];
+					T s = xj[i * rs];
+					for (TIndex k = i + 1; k < n; k++)
+						s -= ui[k - i] * xj[k * rs];
+					xj[i * rs] = unit ? s : s / ui[0];
+				}
+			}
+		}
+	}
+	delete[] u;
+	return X;
+} /*-------------------------------------------------------------------------*/
+
+#endif
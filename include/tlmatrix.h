@@ -0,0 +1,273 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tlmatrix.h
+//
+// Нижнетреугольная матрица и транспонирование верхнетреугольной без копирования.
+//
+// Нижнетреугольная матрица L хранится как верхнетреугольная L^T: строка k
+// хранилища - столбец k матрицы L. Поэтому транспонирование TMatrix U -
+// представление TTransposeView над тем же хранилищем, а TLowerMatrix -
+// та же схема с собственным хранилищем. Ядра (умножение на вектор,
+// решение систем, умножение матриц) выбираются по типу операнда и
+// обходят хранилище по непрерывным строкам в обеих ориентациях.
+
+#ifndef __TLMATRIX_H__
+#define __TLMATRIX_H__
+
+#include "tdmatrix.h"
+
+// Транспонированная верхнетреугольная матрица (нижнетреугольная), без копии
+template <class T>
+class TTransposeView
+{
+protected:
+	const TMatrix<T>* pMatrix;
+public:
+	explicit TTransposeView(const TMatrix<T>& u) : pMatrix(&u) {}
+	const TMatrix<T>& Upper() const { return *pMatrix; } // хранилище (U)
+	TIndex GetSize() const { return pMatrix->GetSize(); }
+	T operator()(TIndex i, TIndex j) const // элемент (i, j), ноль выше диагонали
+	{
+		if (i < 0 || j < 0 || i >= GetSize() || j >= GetSize())
+			throw "bad index";
+		return (j > i) ? T(0) : pMatrix->Row(j).Get_pVector()[i - j];
+	}
+};
+
+template <class T> // U^T
+TTransposeView<T> Transpose(const TMatrix<T>& u)
+{
+	return TTransposeView<T>(u);
+}
+/*-------------------------------------------------------------------------*/
+
+// Нижнетреугольная матрица
+template <class T>
+class TLowerMatrix
+{
+protected:
+	TMatrix<T> Storage; // L^T
+public:
+	TLowerMatrix(TIndex s = 10) : Storage(s) {}
+	TLowerMatrix(const TTransposeView<T>& v) : Storage(v.Upper()) {} // копия U^T
+	TIndex GetSize() const { return Storage.GetSize(); }
+	T& operator()(TIndex i, TIndex j);                  // доступ, j <= i
+	T operator()(TIndex i, TIndex j) const;             // ноль выше диагонали
+	TTransposeView<T> View() const { return TTransposeView<T>(Storage); }
+	const TMatrix<T>& Transposed() const { return Storage; } // L^T без копии
+	void AppendRow(const TVector<T>& r) { Storage.AppendColumn(r); } // r[j] - элемент (N, j); O(N) в среднем
+	void ReserveRows(TIndex n) { Storage.ReserveColumns(n); }       // емкость под порядок n
+	TDiagonal GetDiagonal() const { return Storage.GetDiagonal(); }
+	void SetDiagonal(TDiagonal d) { Storage.SetDiagonal(d); }        // вид диагонали (см. TDiagonal)
+	bool operator==(const TLowerMatrix& m) const { return Storage == m.Storage; }
+	bool operator!=(const TLowerMatrix& m) const { return Storage != m.Storage; }
+
+	// ввод-вывод
+	friend ostream& operator<<(ostream& out, const TLowerMatrix& m)
+	{
+		for (TIndex i = 0; i < m.GetSize(); i++)
+		{
+			for (TIndex j = 0; j <= i; j++)
+				out << m(i, j) << ' ';
+			out << endl;
+		}
+		return out;
+	}
+};
+
+template <class T> // доступ
+T& TLowerMatrix<T>::operator()(TIndex i, TIndex j)
+{
+	if (i < 0 || i >= GetSize() || j < 0 || j > i)
+		throw "bad index";
+	return Storage[j][i];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+T TLowerMatrix<T>::operator()(TIndex i, TIndex j) const
+{
+	return View()(i, j);
+} /*-------------------------------------------------------------------------*/
+
+
+// Умножение на вектор
+
+template <class T> // U * x: строка i - скалярное произведение; известная диагональ не читается
+TVector<T> MatVec(const TMatrix<T>& u, const TVector<T>& x)
+{
+	const TIndex n = u.GetSize();
+	if (x.GetSize() != n)
+		throw "not equal size";
+	TVector<T> y(n);
+	T* py = y.Get_pVector();
+	const T* px = x.Get_pVector();
+	const TDiagonal diag = u.GetDiagonal();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		const T* row = u.Row(i).Get_pVector();
+		if (diag == DIAG_STORED)
+			py[i] = VecDot(row, px + i, n - i);
+		else
+			py[i] = VecDot(row + 1, px + i + 1, n - i - 1) + ((diag == DIAG_UNIT) ? px[i] : T(0));
+	}
+	return y;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // U^T * x: y += x[k] * (строка k хранилища), столбцы y делятся на полосы
+TVector<T> MatVec(const TTransposeView<T>& l, const TVector<T>& x)
+{
+	const TMatrix<T>& u = l.Upper();
+	const TIndex n = u.GetSize();
+	if (x.GetSize() != n)
+		throw "not equal size";
+	const TIndex band = 256;
+	const TIndex nb = (n + band - 1) / band;
+	const TDiagonal diag = u.GetDiagonal();
+	const TIndex skip = (diag == DIAG_STORED) ? 0 : 1; // известная диагональ не читается
+	TVector<T> y(n);
+	T* py = y.Get_pVector();
+	const T* px = x.Get_pVector();
+#pragma omp parallel for schedule(dynamic, 1)
+	for (TIndex b = nb - 1; b >= 0; b--)
+	{
+		const TIndex j0 = b * band;
+		const TIndex j1 = (j0 + band < n) ? j0 + band : n;
+		for (TIndex k = 0; k < j1; k++)
+		{
+			const T* row = u.Row(k).Get_pVector(); // row[j - k] == U[k][j]
+			const T xk = px[k];
+			for (TIndex j = (k + skip > j0) ? k + skip : j0; j < j1; j++)
+				py[j] += xk * row[j - k];
+		}
+		if (diag == DIAG_UNIT)
+			for (TIndex j = j0; j < j1; j++)
+				py[j] += px[j];
+	}
+	return y;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // L * x
+TVector<T> MatVec(const TLowerMatrix<T>& l, const TVector<T>& x)
+{
+	return MatVec(l.View(), x);
+} /*-------------------------------------------------------------------------*/
+
+
+// Решение систем
+
+template <class T> // U x = b, обратная подстановка
+TVector<T> Solve(const TMatrix<T>& u, const TVector<T>& b)
+{
+	const TIndex n = u.GetSize();
+	if (b.GetSize() != n)
+		throw "not equal size";
+	TVector<T> x(b);
+	T* px = x.Get_pVector();
+	const bool unit = u.GetDiagonal() == DIAG_UNIT; // без деления
+	for (TIndex i = n - 1; i >= 0; i--)
+	{
+		const T* row = u.Row(i).Get_pVector();
+		if (!unit && row[0] == T(0))
+			throw "singular matrix";
+		const T r = px[i] - VecDot(row + 1, px + i + 1, n - i - 1);
+		px[i] = unit ? r : r / row[0];
+	}
+	return x;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // U^T x = b, прямая подстановка по строкам хранилища
+TVector<T> Solve(const TTransposeView<T>& l, const TVector<T>& b)
+{
+	const TMatrix<T>& u = l.Upper();
+	const TIndex n = u.GetSize();
+	if (b.GetSize() != n)
+		throw "not equal size";
+	TVector<T> x(b);
+	T* px = x.Get_pVector();
+	const bool unit = u.GetDiagonal() == DIAG_UNIT; // без деления
+	for (TIndex k = 0; k < n; k++)
+	{
+		const T* row = u.Row(k).Get_pVector();
+		if (!unit && row[0] == T(0))
+			throw "singular matrix";
+		const T xk = unit ? px[k] : px[k] / row[0];
+		px[k] = xk;
+		T* rest = px + k + 1;
+		for (TIndex j = 0; j < n - k - 1; j++)
+			rest[j] -= xk * row[j + 1];
+	}
+	return x;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // L x = b
+TVector<T> Solve(const TLowerMatrix<T>& l, const TVector<T>& b)
+{
+	return Solve(l.View(), b);
+} /*-------------------------------------------------------------------------*/
+
+
+// Умножение матриц
+
+template <class T> // A^T * B^T = (B * A)^T
+TLowerMatrix<T> operator*(const TTransposeView<T>& a, const TTransposeView<T>& b)
+{
+	return TLowerMatrix<T>(Transpose(b.Upper() * a.Upper()));
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+TLowerMatrix<T> operator*(const TLowerMatrix<T>& a, const TLowerMatrix<T>& b)
+{
+	return a.View() * b.View();
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // A^T * B: C[i][j] = сумма(k <= min(i, j)) A[k][i] * B[k][j]
+TDenseMatrix<T> operator*(const TTransposeView<T>& a, const TMatrix<T>& b)
+{
+	const TMatrix<T>& u = a.Upper();
+	const TIndex n = u.GetSize();
+	if (b.GetSize() != n)
+		throw "not equal size";
+	TDenseMatrix<T> c(n, n);
+	T* pc = c.Get_pMem();
+	// строка i результата накапливает A[k][i] * (строка k матрицы B), k <= i
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		T* ci = pc + i * n;
+		for (TIndex k = 0; k <= i; k++)
+		{
+			const T aki = u.Row(k).Get_pVector()[i - k];
+			const T* bk = b.Row(k).Get_pVector();
+			T* cik = ci + k;
+			for (TIndex j = 0; j < n - k; j++)
+				cik[j] += aki * bk[j];
+		}
+	}
+	return c;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // A * B^T: C[i][j] = сумма(k >= max(i, j)) A[i][k] * B[j][k]
+TDenseMatrix<T> operator*(const TMatrix<T>& a, const TTransposeView<T>& b)
+{
+	const TMatrix<T>& u = b.Upper();
+	const TIndex n = a.GetSize();
+	if (u.GetSize() != n)
+		throw "not equal size";
+	TDenseMatrix<T> c(n, n);
+	T* pc = c.Get_pMem();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		const T* ai = a.Row(i).Get_pVector();
+		for (TIndex j = 0; j < n; j++)
+		{
+			const T* bj = u.Row(j).Get_pVector();
+			const TIndex k = (i > j) ? i : j;
+			pc[i * n + j] = VecDot(ai + (k - i), bj + (k - j), n - k);
+		}
+	}
+	return c;
+} /*-------------------------------------------------------------------------*/
+
+#endif
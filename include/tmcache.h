@@ -0,0 +1,162 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tmcache.h
+//
+// Кеш результатов операций над верхнетреугольными матрицами:
+// вытеснение давно не использованных (LRU) в пределах бюджета в байтах.
+//
+// Подключение:
+//   TLruMatrixCache<double> cache(256 << 20);
+//   TMatrixCache<double>::Active() = &cache;
+//   ...                                   // a * b, a.Inverse() берутся из кеша
+//   TMatrixCache<double>::Active() = 0;
+//
+// Записи ищутся по 128-битному хешу содержимого операндов. Копии операндов
+// хранятся в записи и при совпадении хеша сравниваются поэлементно:
+// коллизия хешей дает промах, а не чужой результат. Операнды учитываются
+// в бюджете вместе с результатом.
+
+#ifndef __TMCACHE_H__
+#define __TMCACHE_H__
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#error "tmcache.h requires Visual Studio 2015 or newer (<mutex>)"
+#endif
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "utmatrix.h"
+
+struct TMatrixKeyHash
+{
+	size_t operator()(const TMatrixKey& k) const
+	{
+		return (size_t)(k.A.Lo ^ HashRotl(k.B.Lo, 17) ^ ((unsigned long long)k.Op * HASH_P5));
+	}
+};
+
+// приблизительный объем памяти, занимаемой матрицей
+template <class T>
+size_t MatrixBytes(const TMatrix<T>& m)
+{
+	const size_t n = (size_t)m.GetSize();
+	return sizeof(TMatrix<T>) + n * sizeof(TVector<T>) + n * (n + 1) / 2 * sizeof(T);
+}
+
+template <class T>
+class TLruMatrixCache : public TMatrixCache<T>
+{
+protected:
+	struct TEntry
+	{
+		TMatrixKey Key;
+		TMatrix<T> A, B;  // операнды (B пуста у обращения)
+		TMatrix<T> Value;
+		size_t Bytes;
+		TEntry(const TMatrixKey& k, const TMatrix<T>& a, const TMatrix<T>* b, const TMatrix<T>& v, size_t bytes) :
+			Key(k), A(a), B(b ? *b : TMatrix<T>(0)), Value(v), Bytes(bytes) {}
+		bool Same(const TMatrix<T>& a, const TMatrix<T>* b) const // те же операнды
+		{
+			return A == a && (b ? B == *b : B.GetSize() == 0);
+		}
+	};
+	typedef typename std::list<TEntry>::iterator TPos;
+
+	std::list<TEntry> Lru;                              // в начале - последние использованные
+	std::unordered_map<TMatrixKey, TPos, TMatrixKeyHash> Index;
+	std::mutex Lock;
+	size_t Budget;    // предельный объем, байт
+	size_t Bytes;     // занятый объем, байт
+	long long Hits, Misses, Evictions, Collisions;
+
+	void Evict(size_t need); // освободить место под need байт
+public:
+	TLruMatrixCache(size_t budget = 64 << 20);
+	bool Find(const TMatrixKey& key, const TMatrix<T>& a, const TMatrix<T>* b, TMatrix<T>& res);
+	void Store(const TMatrixKey& key, const TMatrix<T>& a, const TMatrix<T>* b, const TMatrix<T>& res);
+	void Clear();
+
+	// статистика
+	long long GetHits() { std::lock_guard<std::mutex> g(Lock); return Hits; }
+	long long GetMisses() { std::lock_guard<std::mutex> g(Lock); return Misses; }
+	long long GetEvictions() { std::lock_guard<std::mutex> g(Lock); return Evictions; }
+	long long GetCollisions() { std::lock_guard<std::mutex> g(Lock); return Collisions; } // ключ совпал, операнды - нет
+	size_t GetBytes() { std::lock_guard<std::mutex> g(Lock); return Bytes; }
+	size_t GetCount() { std::lock_guard<std::mutex> g(Lock); return Index.size(); }
+	size_t GetBudget() const { return Budget; }
+};
+
+template <class T>
+TLruMatrixCache<T>::TLruMatrixCache(size_t budget)
+{
+	Budget = budget;
+	Bytes = 0;
+	Hits = Misses = Evictions = Collisions = 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // поиск; найденная запись становится последней использованной
+bool TLruMatrixCache<T>::Find(const TMatrixKey& key, const TMatrix<T>& a, const TMatrix<T>* b, TMatrix<T>& res)
+{
+	std::lock_guard<std::mutex> g(Lock);
+	typename std::unordered_map<TMatrixKey, TPos, TMatrixKeyHash>::iterator it = Index.find(key);
+	if (it == Index.end())
+	{
+		Misses++;
+		return false;
+	}
+	if (!it->second->Same(a, b))
+	{
+		Collisions++;
+		Misses++;
+		return false;
+	}
+	Hits++;
+	Lru.splice(Lru.begin(), Lru, it->second);
+	res = it->second->Value;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // вытеснение с конца списка
+void TLruMatrixCache<T>::Evict(size_t need)
+{
+	while (!Lru.empty() && Bytes + need > Budget)
+	{
+		Bytes -= Lru.back().Bytes;
+		Index.erase(Lru.back().Key);
+		Lru.pop_back();
+		Evictions++;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сохранение; запись больше бюджета не сохраняется
+void TLruMatrixCache<T>::Store(const TMatrixKey& key, const TMatrix<T>& a, const TMatrix<T>* b, const TMatrix<T>& res)
+{
+	const size_t bytes = MatrixBytes(res) + MatrixBytes(a) + (b ? MatrixBytes(*b) : 0);
+	if (bytes > Budget)
+		return;
+	std::lock_guard<std::mutex> g(Lock);
+	typename std::unordered_map<TMatrixKey, TPos, TMatrixKeyHash>::iterator it = Index.find(key);
+	if (it != Index.end())
+	{
+		// тот же результат мог быть вычислен другим потоком; при коллизии
+		// остается прежняя запись
+		Lru.splice(Lru.begin(), Lru, it->second);
+		return;
+	}
+	Evict(bytes);
+	Lru.push_front(TEntry(key, a, b, res, bytes));
+	Index[key] = Lru.begin();
+	Bytes += bytes;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // очистка (статистика сохраняется)
+void TLruMatrixCache<T>::Clear()
+{
+	std::lock_guard<std::mutex> g(Lock);
+	Lru.clear();
+	Index.clear();
+	Bytes = 0;
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,335 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tqr.h
+//
+// QR-разложение высокой плотной матрицы A (m x n, m >= n) отражениями
+// Хаусхолдера; результат - верхнетреугольный множитель R в TMatrix
+// (A^T A = R^T R, диагональ R неотрицательна).
+//
+// HouseholderQR - блочный алгоритм с компактным представлением WY:
+//   QR_BLOCK отражений полосы столбцов собираются в Q = I - V T V^T, и
+//   оставшиеся столбцы обновляются тремя матричными произведениями
+//   W = V^T C, W = T^T W, C -= V W вместо QR_BLOCK проходов по C.
+//   Обновление делится между потоками по полосам столбцов.
+// TSQR - для очень высоких матриц: блоки строк раскладываются параллельно
+//   и независимо, затем полученные R попарно объединяются по дереву
+//   вращениями Гивенса (QRStack).
+
+#ifndef __TQR_H__
+#define __TQR_H__
+
+#include "tqrupdate.h"
+
+const int QR_BLOCK = 32;   // отражений в полосе
+const TIndex QR_BAND = 64;  // столбцов в полосе обновления одного потока (W - 16 КБ)
+
+// Панель: столбцы [j0, j1), строки [j0, m) раскладываются по одному
+// отражению; v_j хранится под диагональю (v_j[j] = 1 не хранится).
+template <class T>
+void QRPanel(T* p, TIndex rs, TIndex cs, TIndex m, TIndex j0, TIndex j1, T* tau)
+{
+	T* w = new T[j1 - j0];
+	for (TIndex j = j0; j < j1; j++)
+	{
+		T* col = p + j * rs + j * cs; // элемент (j, j)
+		const T alpha = col[0];
+		T ss = 0;
+		for (TIndex i = 1; i < m - j; i++)
+			ss += col[i * rs] * col[i * rs];
+		if (ss == T(0))
+		{
+			tau[j - j0] = 0;
+			continue;
+		}
+		const T norm = (T)sqrt((double)(alpha * alpha + ss));
+		const T beta = (alpha > T(0)) ? -norm : norm;
+		tau[j - j0] = (beta - alpha) / beta;
+		const T scale = T(1) / (alpha - beta);
+		for (TIndex i = 1; i < m - j; i++)
+			col[i * rs] *= scale;
+		col[0] = beta;
+		// столбцы (j, j1) панели: A -= tau v (v^T A)
+		const TIndex nc = j1 - j - 1;
+		const T* rowj = col + cs;
+		for (TIndex c = 0; c < nc; c++)
+			w[c] = rowj[c * cs];
+		for (TIndex i = 1; i < m - j; i++)
+		{
+			const T vi = col[i * rs];
+			const T* ri = col + i * rs + cs;
+			for (TIndex c = 0; c < nc; c++)
+				w[c] += vi * ri[c * cs];
+		}
+		const T t = tau[j - j0];
+		T* wj = col + cs;
+		for (TIndex c = 0; c < nc; c++)
+			wj[c * cs] -= t * w[c];
+		for (TIndex i = 1; i < m - j; i++)
+		{
+			const T tvi = t * col[i * rs];
+			T* ri = col + i * rs + cs;
+			for (TIndex c = 0; c < nc; c++)
+				ri[c * cs] -= tvi * w[c];
+		}
+	}
+	delete[] w;
+} /*-------------------------------------------------------------------------*/
+
+// Треугольный множитель T (b x b, по строкам) для Q = H_0 ... H_(b-1) = I - V T V^T:
+// T[i][i] = tau_i, T[0..i)[i] = -tau_i T[0..i)[0..i) V[:, 0..i)^T v_i.
+template <class T>
+void QRFormT(const T* p, TIndex rs, TIndex cs, TIndex m, TIndex j0, TIndex b, const T* tau, T* t)
+{
+	T* z = new T[b];
+	for (TIndex i = 0; i < b; i++)
+	{
+		const TIndex ri = j0 + i; // строка единицы v_i
+		for (TIndex q = 0; q < i; q++)
+			z[q] = p[ri * rs + (j0 + q) * cs];
+		for (TIndex r = ri + 1; r < m; r++)
+		{
+			const T vi = p[r * rs + ri * cs];
+			const T* row = p + r * rs + j0 * cs;
+			for (TIndex q = 0; q < i; q++)
+				z[q] += row[q * cs] * vi;
+		}
+		for (TIndex q = 0; q < i; q++)
+		{
+			T s = 0;
+			for (TIndex l = q; l < i; l++)
+				s += t[q * b + l] * z[l];
+			t[q * b + i] = -tau[i] * s;
+		}
+		for (TIndex q = i + 1; q < b; q++)
+			t[q * b + i] = 0;
+		t[i * b + i] = tau[i];
+	}
+	delete[] z;
+} /*-------------------------------------------------------------------------*/
+
+// строки [r0, r1), в которых заданы все b векторов: w[q] += v_q[r] * C[r],
+// по четыре вектора за проход по строке C
+template <class T>
+void QRGather(const T* p, TIndex rs, TIndex cs, TIndex r0, TIndex r1, TIndex j0, TIndex b, TIndex c0, TIndex nc, T* w)
+{
+	for (TIndex r = r0; r < r1; r++)
+	{
+		const T* RESTRICT cr = p + r * rs + c0 * cs;
+		const T* vr = p + r * rs + j0 * cs;
+		TIndex q = 0;
+		for (; q + 4 <= b; q += 4)
+		{
+			const T v0 = vr[q * cs], v1 = vr[(q + 1) * cs], v2 = vr[(q + 2) * cs], v3 = vr[(q + 3) * cs];
+			T* RESTRICT w0 = w + q * nc;
+			T* RESTRICT w1 = w0 + nc;
+			T* RESTRICT w2 = w1 + nc;
+			T* RESTRICT w3 = w2 + nc;
+			for (TIndex c = 0; c < nc; c++)
+			{
+				const T x = cr[c * cs];
+				w0[c] += v0 * x;
+				w1[c] += v1 * x;
+				w2[c] += v2 * x;
+				w3[c] += v3 * x;
+			}
+		}
+		for (; q < b; q++)
+		{
+			const T v = vr[q * cs];
+			T* RESTRICT wq = w + q * nc;
+			for (TIndex c = 0; c < nc; c++)
+				wq[c] += v * cr[c * cs];
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// строки [r0, r1), в которых заданы все b векторов: C[r] -= сумма v_q[r] * w[q]
+template <class T>
+void QRScatter(T* p, TIndex rs, TIndex cs, TIndex r0, TIndex r1, TIndex j0, TIndex b, TIndex c0, TIndex nc, const T* w)
+{
+	for (TIndex r = r0; r < r1; r++)
+	{
+		T* RESTRICT cr = p + r * rs + c0 * cs;
+		const T* vr = p + r * rs + j0 * cs;
+		TIndex q = 0;
+		for (; q + 4 <= b; q += 4)
+		{
+			const T v0 = vr[q * cs], v1 = vr[(q + 1) * cs], v2 = vr[(q + 2) * cs], v3 = vr[(q + 3) * cs];
+			const T* RESTRICT w0 = w + q * nc;
+			const T* RESTRICT w1 = w0 + nc;
+			const T* RESTRICT w2 = w1 + nc;
+			const T* RESTRICT w3 = w2 + nc;
+			for (TIndex c = 0; c < nc; c++)
+				cr[c * cs] -= (v0 * w0[c] + v1 * w1[c]) + (v2 * w2[c] + v3 * w3[c]);
+		}
+		for (; q < b; q++)
+		{
+			const T v = vr[q * cs];
+			const T* RESTRICT wq = w + q * nc;
+			for (TIndex c = 0; c < nc; c++)
+				cr[c * cs] -= v * wq[c];
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// C = Q^T C для столбцов [c0, c1) и строк [j0, m): C -= V (T^T (V^T C)).
+// Первые b строк (треугольник V с единицами) обрабатываются поэлементно,
+// остальные - ядрами QRGather, QRScatter.
+template <class T>
+void QRApply(T* p, TIndex rs, TIndex cs, TIndex m, TIndex j0, TIndex b, const T* t, TIndex c0, TIndex c1)
+{
+	const TIndex nc = c1 - c0;
+	T* w = new T[b * nc];
+	for (TIndex l = 0; l < b * nc; l++)
+		w[l] = 0;
+	for (TIndex r = j0; r < j0 + b; r++)
+	{
+		const T* cr = p + r * rs + c0 * cs;
+		const T* vr = p + r * rs + j0 * cs;
+		for (TIndex q = 0; q <= r - j0; q++) // v_q[r] != 0 при q <= r - j0
+		{
+			const T v = (q == r - j0) ? T(1) : vr[q * cs];
+			T* wq = w + q * nc;
+			for (TIndex c = 0; c < nc; c++)
+				wq[c] += v * cr[c * cs];
+		}
+	}
+	QRGather(p, rs, cs, j0 + b, m, j0, b, c0, nc, w);
+	for (TIndex q = b - 1; q >= 0; q--) // W = T^T W, строка q зависит от строк l <= q
+	{
+		T* wq = w + q * nc;
+		const T tqq = t[q * b + q];
+		for (TIndex c = 0; c < nc; c++)
+			wq[c] *= tqq;
+		for (TIndex l = 0; l < q; l++)
+		{
+			const T tlq = t[l * b + q];
+			const T* wl = w + l * nc;
+			for (TIndex c = 0; c < nc; c++)
+				wq[c] += tlq * wl[c];
+		}
+	}
+	for (TIndex r = j0; r < j0 + b; r++)
+	{
+		T* cr = p + r * rs + c0 * cs;
+		const T* vr = p + r * rs + j0 * cs;
+		for (TIndex q = 0; q <= r - j0; q++)
+		{
+			const T v = (q == r - j0) ? T(1) : vr[q * cs];
+			const T* wq = w + q * nc;
+			for (TIndex c = 0; c < nc; c++)
+				cr[c * cs] -= v * wq[c];
+		}
+	}
+	QRScatter(p, rs, cs, j0 + b, m, j0, b, c0, nc, w);
+	delete[] w;
+} /*-------------------------------------------------------------------------*/
+
+// Разложение на месте: над диагональю a - R, под диагональю - векторы
+// отражений. R копируется в r со знаком, дающим неотрицательную диагональ.
+template <class T>
+void HouseholderQR(TDenseMatrix<T>& a, TMatrix<T>& r)
+{
+	const TIndex m = a.GetRows(), n = a.GetCols();
+	if (m < n)
+		throw "wrong size";
+	r = TMatrix<T>(n);
+	T* p = a.Get_pMem();
+	const TIndex rs = a.RowStride(), cs = a.ColStride();
+	T tau[QR_BLOCK], t[QR_BLOCK * QR_BLOCK];
+	for (TIndex j0 = 0; j0 < n; j0 += QR_BLOCK)
+	{
+		const TIndex j1 = (j0 + QR_BLOCK < n) ? j0 + QR_BLOCK : n, b = j1 - j0;
+		QRPanel(p, rs, cs, m, j0, j1, tau);
+		if (j1 == n)
+			break;
+		QRFormT(p, rs, cs, m, j0, b, tau, t);
+		const TIndex nb = (n - j1 + QR_BAND - 1) / QR_BAND;
+#pragma omp parallel for schedule(dynamic, 1)
+		for (TIndex k = 0; k < nb; k++)
+		{
+			const TIndex c0 = j1 + k * QR_BAND;
+			QRApply(p, rs, cs, m, j0, b, t, c0, (c0 + QR_BAND < n) ? c0 + QR_BAND : n);
+		}
+	}
+	TVector<T>* rows = r.Get_pVector();
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		T* ri = rows[i].Get_pVector();
+		const T* ai = p + i * rs + i * cs;
+		const T sign = (ai[0] < T(0)) ? T(-1) : T(1);
+		for (TIndex c = 0; c < n - i; c++)
+			ri[c] = sign * ai[c * cs];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // R, A не изменяется
+TMatrix<T> HouseholderQR(const TDenseMatrix<T>& a)
+{
+	TDenseMatrix<T> work(a);
+	TMatrix<T> r(0);
+	HouseholderQR(work, r);
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+// R матрицы [R1; R2] в r1: строка k матрицы R2 вращениями переносится
+// в строки k, k + 1, ... матрицы R1
+template <class T>
+void QRStack(TMatrix<T>& r1, const TMatrix<T>& r2)
+{
+	const TIndex n = r1.GetSize();
+	if (r2.GetSize() != n)
+		throw "not equal size";
+	TVector<T>* rows = r1.Get_pVector();
+	TVector<T> w(n);
+	T* pw = w.Get_pVector();
+	for (TIndex k = 0; k < n; k++)
+	{
+		const T* r2k = r2.Row(k).Get_pVector();
+		for (TIndex c = 0; c < n - k; c++)
+			pw[c] = r2k[c];
+		for (TIndex j = k; j < n; j++)
+		{
+			T* rj = rows[j].Get_pVector();
+			T c, s;
+			Givens(rj[0], pw[j - k], c, s);
+			VecRotate(c, s, rj, pw + (j - k), n - j);
+		}
+	}
+} /*-------------------------------------------------------------------------*/
+
+// Блоки по rows строк (последний - с остатком), по умолчанию 8 n;
+// блоки раскладываются параллельно, R объединяются попарно по дереву.
+template <class T>
+TMatrix<T> TSQR(const TDenseMatrix<T>& a, TIndex rows = 0)
+{
+	const TIndex m = a.GetRows(), n = a.GetCols();
+	if (m < n)
+		throw "wrong size";
+	TIndex h = (rows > 0) ? rows : 8 * n;
+	h = (h < n) ? n : h;
+	const TIndex nb = (m / h > 0) ? m / h : 1;
+	TMatrix<T>* part = new TMatrix<T>[nb];
+#pragma omp parallel for schedule(dynamic, 1)
+	for (TIndex b = 0; b < nb; b++)
+	{
+		const TIndex i0 = b * h, i1 = (b == nb - 1) ? m : i0 + h;
+		TDenseMatrix<T> block(i1 - i0, n);
+		for (TIndex i = i0; i < i1; i++)
+			for (TIndex j = 0; j < n; j++)
+				block(i - i0, j) = a(i, j);
+		HouseholderQR(block, part[b]);
+	}
+	for (TIndex step = 1; step < nb; step *= 2)
+	{
+#pragma omp parallel for schedule(dynamic, 1)
+		for (TIndex b = 0; b < nb - step; b += 2 * step)
+			QRStack(part[b], part[b + step]);
+	}
+	TMatrix<T> r(std::move(part[0]));
+	delete[] part;
+	return r;
+} /*-------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,146 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tqrupdate.h
+//
+// Обновление верхнетреугольного множителя R (A = QR, R^T R = A^T A) без
+// повторного разложения: добавление и удаление строки матрицы A
+// (R^T R +- x x^T) и удаление столбца A - за O(N^2) вращениями Гивенса.
+//
+// Вращение применяется к паре непрерывных отрезков (строка R и рабочий
+// вектор), поэтому каждое обновление - N проходов ядра VecRotate по строкам
+// хранилища подряд, без обращений по столбцам.
+//
+// Q не хранится: изменяется только R, на месте.
+
+#ifndef __TQRUPDATE_H__
+#define __TQRUPDATE_H__
+
+#include "tlmatrix.h"
+
+template <class T> // вращение пары отрезков: x' = c x + s y, y' = c y - s x
+void VecRotate(T c, T s, T* RESTRICT x, T* RESTRICT y, TIndex n)
+{
+	for (TIndex i = 0; i < n; i++)
+	{
+		const T xi = x[i], yi = y[i];
+		x[i] = c * xi + s * yi;
+		y[i] = c * yi - s * xi;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // вращение, переводящее (a, b) в (r, 0), r = sqrt(a^2 + b^2) >= 0
+void Givens(T a, T b, T& c, T& s)
+{
+	const T r = (T)hypot((double)a, (double)b);
+	if (r == T(0))
+	{
+		c = 1;
+		s = 0;
+		return;
+	}
+	c = a / r;
+	s = b / r;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // R^T R + x x^T: строка k поворачивается вместе с остатком x
+void RankOneUpdate(TMatrix<T>& r, const TVector<T>& x)
+{
+	const TIndex n = r.GetSize();
+	if (x.GetSize() != n)
+		throw "not equal size";
+	TVector<T> w(x);
+	T* pw = w.Get_pVector();
+	for (TIndex k = 0; k < n; k++)
+	{
+		T* rk = r[k].Get_pVector();
+		T c, s;
+		Givens(rk[0], pw[k], c, s);
+		VecRotate(c, s, rk, pw + k, n - k);
+	}
+} /*-------------------------------------------------------------------------*/
+
+// R^T R - x x^T (алгоритм LINPACK DCHDD). Сначала решается R^T p = x;
+// при |p| >= 1 результат не положительно определен и R не изменяется.
+// Затем вращения, накапливающие p в sqrt(1 - |p|^2), применяются к строкам R
+// снизу вверх; рабочий вектор в конце равен x.
+template <class T>
+void RankOneDowndate(TMatrix<T>& r, const TVector<T>& x)
+{
+	const TIndex n = r.GetSize();
+	if (x.GetSize() != n)
+		throw "not equal size";
+	const TMatrix<T>& cr = r;
+	TVector<T> p = Solve(Transpose(cr), x);
+	const T* pp = p.Get_pVector();
+	T norm = 0;
+	for (TIndex k = 0; k < n; k++)
+		norm += pp[k] * pp[k];
+	if (!(norm < T(1)))
+		throw "not positive definite";
+	TVector<T> c(n), s(n);
+	T* pc = c.Get_pVector();
+	T* ps = s.Get_pVector();
+	T alpha = (T)sqrt((double)(T(1) - norm));
+	for (TIndex k = n - 1; k >= 0; k--)
+	{
+		Givens(alpha, pp[k], pc[k], ps[k]);
+		alpha = pc[k] * alpha + ps[k] * pp[k];
+	}
+	TVector<T> w(n);
+	T* pw = w.Get_pVector();
+	for (TIndex k = n - 1; k >= 0; k--)
+		VecRotate(pc[k], -ps[k], r[k].Get_pVector(), pw + k, n - k);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // R для A с добавленной строкой a
+void InsertRow(TMatrix<T>& r, const TVector<T>& a)
+{
+	RankOneUpdate(r, a);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // R для A без строки a
+void DeleteRow(TMatrix<T>& r, const TVector<T>& a)
+{
+	RankOneDowndate(r, a);
+} /*-------------------------------------------------------------------------*/
+
+// R для A без столбца k, порядок уменьшается на 1. Строки ниже k после
+// удаления столбца образуют хессенбергову полосу: строка k без диагонали
+// переносится в рабочий вектор и вращениями спускается по строкам k + 1, ...,
+// оставляя на месте каждой строки ее преобразованную копию.
+template <class T>
+void DeleteColumn(TMatrix<T>& r, TIndex k)
+{
+	const TIndex n = r.GetSize();
+	if (k < 0 || k >= n)
+		throw "bad index";
+	TMatrix<T> res(n - 1);
+	for (TIndex i = 0; i < k; i++)
+	{
+		const T* ri = r.Row(i).Get_pVector();
+		T* di = res[i].Get_pVector();
+		for (TIndex j = 0; j < k - i; j++)
+			di[j] = ri[j];
+		for (TIndex j = k - i + 1; j < n - i; j++)
+			di[j - 1] = ri[j];
+	}
+	TVector<T> w(n - 1 - k);
+	T* pw = w.Get_pVector();
+	const T* rk = r.Row(k).Get_pVector();
+	for (TIndex j = 0; j < n - 1 - k; j++)
+		pw[j] = rk[j + 1];
+	for (TIndex j = k; j < n - 1; j++)
+	{
+		const T* src = r.Row(j + 1).Get_pVector();
+		T* dj = res[j].Get_pVector();
+		for (TIndex l = 0; l < n - 1 - j; l++)
+			dj[l] = src[l];
+		T c, s;
+		Givens(dj[0], pw[0], c, s);
+		VecRotate(c, s, dj, pw, n - 1 - j);
+		pw++; // pw[0] обнулен
+	}
+	r = std::move(res);
+} /*-------------------------------------------------------------------------*/
+
+#endif
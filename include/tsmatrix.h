@@ -0,0 +1,316 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tsmatrix.h
+//
+// Симметричная матрица в треугольном хранилище TMatrix: хранится только
+// верхний треугольник (i <= j), элемент (j, i) читается из (i, j).
+//
+// Ядра читают каждый хранимый элемент один раз:
+//   SYMV: y = A x, строка i дает и y[i] (скалярное произведение), и вклад
+//         симметричной части в y[i + 1..] (axpy) за один проход;
+//   SYRK: C = beta C + alpha A^T A, вычисляются только плитки треугольника.
+
+#ifndef __TSMATRIX_H__
+#define __TSMATRIX_H__
+
+#include "tdmatrix.h"
+
+// Симметричная матрица
+template <class T>
+class TSymMatrix
+{
+protected:
+	TMatrix<T> Storage; // верхний треугольник
+public:
+	TSymMatrix(TIndex s = 10) : Storage(s) {}
+	explicit TSymMatrix(const TMatrix<T>& u) : Storage(u) {}  // по верхнему треугольнику u
+	explicit TSymMatrix(const TDenseMatrix<T>& a);            // по верхнему треугольнику a
+	TIndex GetSize() const { return Storage.GetSize(); }
+	T& operator()(TIndex i, TIndex j);                  // доступ, (i, j) и (j, i) - один элемент
+	const T& operator()(TIndex i, TIndex j) const;
+	const TMatrix<T>& Upper() const { return Storage; } // хранилище без копии
+	TMatrix<T>& Upper() { return Storage; }
+	bool operator==(const TSymMatrix& m) const { return Storage == m.Storage; }
+	bool operator!=(const TSymMatrix& m) const { return Storage != m.Storage; }
+	TSymMatrix operator+(const TSymMatrix& m);          // сложение
+	TSymMatrix operator-(const TSymMatrix& m);          // вычитание
+	TSymMatrix& operator+=(const TSymMatrix& m);        // сложение на месте
+
+	// ввод-вывод
+	friend ostream& operator<<(ostream& out, const TSymMatrix& m)
+	{
+		for (TIndex i = 0; i < m.GetSize(); i++)
+		{
+			for (TIndex j = 0; j < m.GetSize(); j++)
+				out << m(i, j) << ' ';
+			out << endl;
+		}
+		return out;
+	}
+};
+
+template <class T>
+TSymMatrix<T>::TSymMatrix(const TDenseMatrix<T>& a) : Storage(a.GetRows())
+{
+	if (a.GetRows() != a.GetCols())
+		throw "wrong size";
+	for (TIndex i = 0; i < GetSize(); i++)
+	{
+		T* row = Storage[i].Get_pVector();
+		for (TIndex j = i; j < GetSize(); j++)
+			row[j - i] = a(i, j);
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+T& TSymMatrix<T>::operator()(TIndex i, TIndex j)
+{
+	if (i < 0 || j < 0 || i >= GetSize() || j >= GetSize())
+		throw "bad index";
+	return (i <= j) ? Storage[i][j] : Storage[j][i];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+const T& TSymMatrix<T>::operator()(TIndex i, TIndex j) const
+{
+	if (i < 0 || j < 0 || i >= GetSize() || j >= GetSize())
+		throw "bad index";
+	return (i <= j) ? Storage[i][j] : Storage[j][i];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сложение
+TSymMatrix<T> TSymMatrix<T>::operator+(const TSymMatrix<T>& m)
+{
+	TSymMatrix<T> res(*this);
+	return res += m;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // вычитание
+TSymMatrix<T> TSymMatrix<T>::operator-(const TSymMatrix<T>& m)
+{
+	return TSymMatrix<T>(Storage - m.Storage);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сложение на месте: строки складываются параллельно
+TSymMatrix<T>& TSymMatrix<T>::operator+=(const TSymMatrix<T>& m)
+{
+	const TIndex n = GetSize();
+	if (m.GetSize() != n)
+		throw "not equal size";
+	TVector<T>* rows = Storage.Get_pVector(); // разделяемое хранилище отделяется до цикла
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		T* c = rows[i].Get_pVector();
+		const T* b = m.Storage.Row(i).Get_pVector();
+		for (TIndex j = 0; j < n - i; j++)
+			c[j] += b[j];
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+
+// Умножение на вектор
+
+template <class T> // y[1..n) += a * r[1..n), возвращает сумму r[j] * x[j]
+T VecDotAxpy(const T* RESTRICT r, const T* RESTRICT x, T a, T* RESTRICT y, TIndex n)
+{
+	T s0 = r[0] * x[0], s1 = 0;
+	TIndex j = 1;
+	for (; j + 2 <= n; j += 2)
+	{
+		s0 += r[j] * x[j];
+		s1 += r[j + 1] * x[j + 1];
+		y[j] += a * r[j];
+		y[j + 1] += a * r[j + 1];
+	}
+	for (; j < n; j++)
+	{
+		s0 += r[j] * x[j];
+		y[j] += a * r[j];
+	}
+	return s0 + s1;
+} /*-------------------------------------------------------------------------*/
+
+// y = A x. Вклады симметричной части пишут в чужие элементы y, поэтому
+// каждый поток накапливает свою копию y, копии складываются в конце.
+template <class T>
+TVector<T> MatVec(const TSymMatrix<T>& a, const TVector<T>& x)
+{
+	const TMatrix<T>& u = a.Upper();
+	const TIndex n = u.GetSize();
+	if (x.GetSize() != n)
+		throw "not equal size";
+	TVector<T> y(n);
+	T* py = y.Get_pVector();
+	const T* px = x.Get_pVector();
+#pragma omp parallel
+	{
+		TVector<T> part(n);
+		T* pp = part.Get_pVector();
+#pragma omp for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < n; i++)
+			pp[i] += VecDotAxpy(u.Row(i).Get_pVector(), px + i, px[i], pp + i, n - i);
+#pragma omp critical
+		for (TIndex i = 0; i < n; i++)
+			py[i] += pp[i];
+	}
+	return y;
+} /*-------------------------------------------------------------------------*/
+
+
+// Обновление ранга k (SYRK): C = beta C + alpha A^T A, A - k x n (строки A -
+// наблюдения), вычисляется только верхний треугольник C.
+// Столбцы C обрабатываются панелями по SYRK_NC, строки A - порциями по
+// SYRK_KC. Порция панели упаковывается в полосы по SYRK_NR столбцов
+// (полоса - SYRK_KC строк по SYRK_NR подряд) и занимает SYRK_KC x SYRK_NC
+// элементов (2 МБ для double) независимо от n, так что остается в кеше L2/L3,
+// пока по ней проходят все строки C. Строки C над панелью и в ней делятся
+// на блоки по SYRK_MC; блок левее панели поток упаковывает в тот же формат
+// (128 КБ), блок внутри панели берется из нее, и блок умножается на панель. Ядро читает обе полосы непрерывно при любом
+// порядке хранения A.
+// Ядро SyrkKernel накапливает плитку SYRK_MR x SYRK_NR в локальном массиве
+// постоянного размера, который компилятор держит в векторных регистрах.
+// Плитки ниже диагонали не вычисляются: FLOP вдвое меньше, чем у
+// произведения A^T A целиком. Потоки делят блоки строк C.
+
+const int SYRK_MR = 4;       // строк в плитке
+const int SYRK_NR = 8;       // столбцов в плитке (кратно SYRK_MR)
+const TIndex SYRK_KC = 256;  // строк A в порции
+const TIndex SYRK_MC = 64;   // строк C в блоке потока (кратно SYRK_NR)
+const TIndex SYRK_NC = 1024; // столбцов C в панели (кратно SYRK_MC)
+
+template <class T> // acc[q][l] = сумма по r a[r][q] * b[r][l], строки полос - по SYRK_NR
+void SyrkKernel(const T* a, const T* b, TIndex kc, T* acc)
+{
+	T c[SYRK_MR][SYRK_NR];
+	for (int q = 0; q < SYRK_MR; q++)
+		for (int l = 0; l < SYRK_NR; l++)
+			c[q][l] = 0;
+	for (TIndex r = 0; r < kc; r++)
+	{
+		const T* ar = a + r * SYRK_NR;
+		const T* br = b + r * SYRK_NR;
+		for (int q = 0; q < SYRK_MR; q++)
+			for (int l = 0; l < SYRK_NR; l++)
+				c[q][l] += ar[q] * br[l];
+	}
+	for (int q = 0; q < SYRK_MR; q++)
+		for (int l = 0; l < SYRK_NR; l++)
+			acc[q * SYRK_NR + l] = c[q][l];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // полоса jp столбцов [c0, c1) строк r0..r0 + kc матрицы A; вне c1 - нули
+void SyrkPackBand(const T* pa, TIndex rs, TIndex cs, TIndex r0, TIndex kc, TIndex c0, TIndex c1, TIndex jp, T* dst)
+{
+	dst += jp * SYRK_NR * kc;
+	for (TIndex r = 0; r < kc; r++)
+		for (int l = 0; l < SYRK_NR; l++)
+		{
+			const TIndex j = c0 + jp * SYRK_NR + l;
+			dst[r * SYRK_NR + l] = (j < c1) ? pa[(r0 + r) * rs + j * cs] : T(0);
+		}
+} /*-------------------------------------------------------------------------*/
+
+// C = beta C + alpha A^T A, A[r][j] = pa[r * rs + j * cs], r < k, j < n.
+// Элемент (i, j) C - pc[i][j - i - off]: off = 0 - хранилище TMatrix,
+// off = 1 - строго верхний треугольник без диагонали (диагональ не
+// вычисляется). Шаги задаются явно, чтобы передать A^T без копии.
+// Как в BLAS, при beta = 0 исходное содержимое C не используется.
+template <class T>
+void SyrkRows(T** pc, TIndex n, TIndex off, const T* pa, TIndex k, TIndex rs, TIndex cs, T alpha, T beta)
+{
+	if (beta != T(1))
+	{
+#pragma omp parallel for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < n; i++)
+			for (TIndex j = 0; j < n - i - off; j++)
+				pc[i][j] = (beta == T(0)) ? T(0) : pc[i][j] * beta;
+	}
+	T* panel = new T[SYRK_NC * SYRK_KC];
+	for (TIndex j0 = 0; j0 < n; j0 += SYRK_NC)
+	{
+		const TIndex j1 = (j0 + SYRK_NC < n) ? j0 + SYRK_NC : n;
+		const TIndex np = (j1 - j0 + SYRK_NR - 1) / SYRK_NR; // полос в панели
+		const TIndex nb = (j1 + SYRK_MC - 1) / SYRK_MC;      // блоков строк C, i < j1
+		for (TIndex r0 = 0; r0 < k; r0 += SYRK_KC)
+		{
+			const TIndex kc = (r0 + SYRK_KC < k) ? SYRK_KC : k - r0;
+#pragma omp parallel for schedule(static)
+			for (TIndex jp = 0; jp < np; jp++)
+				SyrkPackBand(pa, rs, cs, r0, kc, j0, j1, jp, panel);
+#pragma omp parallel
+			{
+				T* block = new T[SYRK_MC * SYRK_KC];
+				T acc[SYRK_MR * SYRK_NR];
+#pragma omp for schedule(dynamic, 1)
+				for (TIndex ib = 0; ib < nb; ib++)
+				{
+					const TIndex i0 = ib * SYRK_MC, i1 = (i0 + SYRK_MC < j1) ? i0 + SYRK_MC : j1;
+					// блок внутри панели уже упакован в ней, левее - упаковывается
+					const T* src = panel;
+					TIndex c0 = j0;
+					if (i0 < j0)
+					{
+						for (TIndex ip = 0; ip < (i1 - i0 + SYRK_NR - 1) / SYRK_NR; ip++)
+							SyrkPackBand(pa, rs, cs, r0, kc, i0, i1, ip, block);
+						src = block;
+						c0 = i0;
+					}
+					for (TIndex is = i0; is < i1; is += SYRK_MR)
+					{
+						// строки is..is + SYRK_MR внутри полосы (is - c0) / SYRK_NR упаковки
+						const T* ai = src + ((is - c0) / SYRK_NR) * SYRK_NR * kc + (is - c0) % SYRK_NR;
+						const TIndex jb0 = (is > j0) ? (is - j0) / SYRK_NR : 0; // полосы левее диагонали пропускаются
+						for (TIndex jp = jb0; jp < np; jp++)
+						{
+							SyrkKernel(ai, panel + jp * SYRK_NR * kc, kc, acc);
+							for (int q = 0; q < SYRK_MR && is + q < i1; q++)
+							{
+								const TIndex i = is + q;
+								for (int l = 0; l < SYRK_NR; l++)
+								{
+									const TIndex j = j0 + jp * SYRK_NR + l;
+									if (j >= i + off && j < j1)
+										pc[i][j - i - off] += alpha * acc[q * SYRK_NR + l];
+								}
+							}
+						}
+					}
+				}
+				delete[] block;
+			}
+		}
+	}
+	delete[] panel;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // C = beta C + alpha A^T A, верхний треугольник
+void Syrk(TMatrix<T>& c, const TDenseMatrix<T>& a, T alpha = 1, T beta = 1)
+{
+	const TIndex n = c.GetSize();
+	if (a.GetCols() != n)
+		throw "not equal size";
+	TVector<T>* rows = c.Get_pVector();
+	T** pc = new T*[n];
+	for (TIndex i = 0; i < n; i++)
+		pc[i] = rows[i].Get_pVector(); // разделяемые строки отделяются до параллельной части
+	SyrkRows(pc, n, 0, a.Get_pMem(), a.GetRows(), a.RowStride(), a.ColStride(), alpha, beta);
+	delete[] pc;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // A^T A
+TMatrix<T> Gram(const TDenseMatrix<T>& a)
+{
+	TMatrix<T> c(a.GetCols());
+	Syrk(c, a);
+	return c;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // C += alpha A^T A
+void RankKUpdate(TSymMatrix<T>& c, const TDenseMatrix<T>& a, T alpha = 1)
+{
+	Syrk(c.Upper(), a, alpha);
+} /*-------------------------------------------------------------------------*/
+
+#endif
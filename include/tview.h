@@ -0,0 +1,339 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tview.h
+//
+// Представления (views) векторов и матриц без копирования данных:
+//   TVectorSpan  - непрерывный или с шагом участок массива
+//   TColumnView  - столбец верхнетреугольной матрицы (только чтение)
+//   TBlockView   - прямоугольный или треугольный блок верхнетреугольной матрицы
+// и ядра над ними. Представление не владеет данными и действительно,
+// пока жив исходный объект и его буфер не перераспределен.
+// Представление с константным типом элемента (TVectorSpan<const T>)
+// создается от константного объекта и не отделяет разделяемый буфер (см.
+// CopyOnWrite), неконстантное - отделяет при создании.
+
+#ifndef __TVIEW_H__
+#define __TVIEW_H__
+
+#include <type_traits>
+#include "utmatrix.h"
+
+// Участок массива: элементы pData[0], pData[Stride], ..., pData[(Size - 1) * Stride]
+template <class T>
+class TVectorSpan
+{
+protected:
+	T* pData;
+	TIndex Size;   // число элементов
+	TIndex Stride; // шаг между элементами
+public:
+	typedef typename std::remove_const<T>::type value_type;
+
+	TVectorSpan(T* p = 0, TIndex n = 0, TIndex stride = 1) : pData(p), Size(n), Stride(stride)
+	{
+		if (n < 0 || stride < 1)
+			throw "wrong size";
+	}
+	template <class U> // неконстантный участок приводится к константному
+	TVectorSpan(const TVectorSpan<U>& s) : pData(s.Data()), Size(s.GetSize()), Stride(s.GetStride()) {}
+
+	T* Data() const { return pData; }
+	TIndex GetSize() const { return Size; }
+	TIndex GetStride() const { return Stride; }
+	bool IsContiguous() const { return Stride == 1; }
+	T& operator[](TIndex i) const // доступ, индексы с нуля
+	{
+		if (i < 0 || i >= Size)
+			throw "bad index";
+		return pData[i * Stride];
+	}
+	TVectorSpan Sub(TIndex first, TIndex count, TIndex step = 1) const // участок участка
+	{
+		if (first < 0 || count < 0 || step < 1 || (count > 0 && first + (count - 1) * step >= Size))
+			throw "bad index";
+		return TVectorSpan(pData + first * Stride, count, Stride * step);
+	}
+};
+
+// Участки вектора. first - индекс в нумерации вектора (с учетом StartIndex)
+template <class T>
+TVectorSpan<T> Span(TVector<T>& v)
+{
+	return TVectorSpan<T>(v.Get_pVector(), v.GetSize());
+}
+
+template <class T>
+TVectorSpan<const T> Span(const TVector<T>& v)
+{
+	return TVectorSpan<const T>(v.Get_pVector(), v.GetSize());
+}
+
+template <class T>
+TVectorSpan<T> Span(TVector<T>& v, TIndex first, TIndex count, TIndex step = 1)
+{
+	return Span(v).Sub(first - v.GetStartIndex(), count, step);
+}
+
+template <class T>
+TVectorSpan<const T> Span(const TVector<T>& v, TIndex first, TIndex count, TIndex step = 1)
+{
+	return Span(v).Sub(first - v.GetStartIndex(), count, step);
+}
+
+// Хранимая часть строки i матрицы: столбцы i..N-1
+template <class T>
+TVectorSpan<T> RowSpan(TMatrix<T>& m, TIndex i)
+{
+	return Span(m[i]);
+}
+
+template <class T>
+TVectorSpan<const T> RowSpan(const TMatrix<T>& m, TIndex i)
+{
+	if (i < 0 || i >= m.GetSize())
+		throw "bad index";
+	return Span(m.Row(i));
+}
+
+template <class T> // копия участка в новый вектор
+TVector<typename std::remove_const<T>::type> ToVector(const TVectorSpan<T>& s)
+{
+	TVector<typename std::remove_const<T>::type> v(s.GetSize());
+	for (TIndex i = 0; i < s.GetSize(); i++)
+		v[i] = s.Data()[i * s.GetStride()];
+	return v;
+}
+/*-------------------------------------------------------------------------*/
+
+// Столбец j матрицы: элементы (0, j), ..., (j, j). Элементы столбца
+// лежат в разных строках, поэтому представление косвенное.
+template <class T>
+class TColumnView
+{
+protected:
+	const TMatrix<T>* pMatrix;
+	TIndex Col;
+public:
+	TColumnView(const TMatrix<T>& m, TIndex j) : pMatrix(&m), Col(j)
+	{
+		if (j < 0 || j >= m.GetSize())
+			throw "bad index";
+	}
+	TIndex GetSize() const { return Col + 1; }
+	TIndex GetCol() const { return Col; }
+	const T& operator[](TIndex i) const
+	{
+		if (i < 0 || i > Col)
+			throw "bad index";
+		return pMatrix->Row(i).Get_pVector()[Col - i];
+	}
+};
+/*-------------------------------------------------------------------------*/
+
+// Блок строк [r0, r1) и столбцов [c0, c1) матрицы. Элементы ниже
+// диагонали (j < i) нулевые и не хранятся: строка k блока хранит столбцы
+// RowStart(k)..c1-1 (в локальной нумерации блока). Диагональный блок
+// (r0 == c0, r1 == c1) - верхнетреугольный, блок выше диагонали (c0 >= r1) -
+// плотный прямоугольный.
+template <class T>
+class TBlockView
+{
+public:
+	typedef typename std::remove_const<T>::type value_type;
+	typedef typename std::conditional<std::is_const<T>::value,
+		const TMatrix<value_type>, TMatrix<value_type> >::type matrix_type;
+protected:
+	matrix_type* pMatrix;
+	TIndex R0, R1, C0, C1;
+
+	static T* RowData(TMatrix<value_type>& m, TIndex i) { return m[i].Get_pVector(); }
+	static T* RowData(const TMatrix<value_type>& m, TIndex i) { return m.Row(i).Get_pVector(); }
+public:
+	TBlockView(matrix_type& m, TIndex r0, TIndex r1, TIndex c0, TIndex c1) : pMatrix(&m), R0(r0), R1(r1), C0(c0), C1(c1)
+	{
+		if (r0 < 0 || r1 < r0 || c0 < 0 || c1 < c0 || r1 > m.GetSize() || c1 > m.GetSize())
+			throw "bad index";
+	}
+	TIndex GetRows() const { return R1 - R0; }
+	TIndex GetCols() const { return C1 - C0; }
+	TIndex RowStart(TIndex k) const // первый хранимый столбец строки k (локально)
+	{
+		TIndex j = R0 + k - C0;
+		return (j > 0) ? ((j < C1 - C0) ? j : C1 - C0) : 0;
+	}
+	TVectorSpan<T> Row(TIndex k) const // хранимая часть строки k блока
+	{
+		if (k < 0 || k >= R1 - R0)
+			throw "bad index";
+		const TIndex i = R0 + k, s = RowStart(k);
+		return TVectorSpan<T>(RowData(*pMatrix, i) + (C0 + s - i), C1 - C0 - s);
+	}
+	value_type Get(TIndex k, TIndex l) const // элемент (k, l) блока, ноль ниже диагонали
+	{
+		if (k < 0 || k >= R1 - R0 || l < 0 || l >= C1 - C0)
+			throw "bad index";
+		const TIndex s = RowStart(k);
+		return (l < s) ? value_type(0) : Row(k).Data()[l - s];
+	}
+};
+
+template <class T> // блок строк [r0, r1), столбцов [c0, c1)
+TBlockView<T> Block(TMatrix<T>& m, TIndex r0, TIndex r1, TIndex c0, TIndex c1)
+{
+	return TBlockView<T>(m, r0, r1, c0, c1);
+}
+
+template <class T>
+TBlockView<const T> Block(const TMatrix<T>& m, TIndex r0, TIndex r1, TIndex c0, TIndex c1)
+{
+	return TBlockView<const T>(m, r0, r1, c0, c1);
+}
+
+template <class T> // диагональный (треугольный) блок [k0, k1)
+TBlockView<T> TriBlock(TMatrix<T>& m, TIndex k0, TIndex k1)
+{
+	return TBlockView<T>(m, k0, k1, k0, k1);
+}
+
+template <class T>
+TBlockView<const T> TriBlock(const TMatrix<T>& m, TIndex k0, TIndex k1)
+{
+	return TBlockView<const T>(m, k0, k1, k0, k1);
+}
+/*-------------------------------------------------------------------------*/
+
+// Ядра над участками. Непрерывные участки обрабатываются ядрами Vec*
+// из utmatrix.h, участки с шагом - поэлементно. Арифметические операторы
+// TVector (+, -, *) создают новый вектор и принимают только TVector;
+// участок вектора обрабатывается ядрами ниже без копирования.
+
+template <class A, class B> // скалярное произведение
+typename std::remove_const<A>::type Dot(const TVectorSpan<A>& x, const TVectorSpan<B>& y)
+{
+	typedef typename std::remove_const<A>::type E;
+	if (x.GetSize() != y.GetSize())
+		throw "not equal size";
+	if (x.IsContiguous() && y.IsContiguous())
+		return VecDot<E>(x.Data(), y.Data(), x.GetSize());
+	E s = 0;
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		s += x.Data()[i * x.GetStride()] * y.Data()[i * y.GetStride()];
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class T, class B> // скалярное произведение столбца матрицы и участка
+T Dot(const TColumnView<T>& x, const TVectorSpan<B>& y)
+{
+	if (x.GetSize() != y.GetSize())
+		throw "not equal size";
+	T s = 0;
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		s += x[i] * y.Data()[i * y.GetStride()];
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class T, class A> // y += alpha * x
+void Axpy(const T& alpha, const TVectorSpan<A>& x, const TVectorSpan<T>& y)
+{
+	if (x.GetSize() != y.GetSize())
+		throw "not equal size";
+	const TIndex n = x.GetSize();
+	A* px = x.Data();
+	T* py = y.Data();
+	// VecAxpy предполагает непересекающиеся x и y (RESTRICT); участки одной
+	// строки с перекрытием обновляются поэлементно по порядку
+	const bool overlap = std::less<const T*>()(px, py + n) && std::less<const T*>()(py, px + n);
+	if (x.IsContiguous() && y.IsContiguous() && !overlap)
+	{
+		VecAxpy<T>(alpha, px, py, n);
+		return;
+	}
+	for (TIndex i = 0; i < n; i++)
+		py[i * y.GetStride()] += alpha * px[i * x.GetStride()];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // x *= alpha
+void Scale(const TVectorSpan<T>& x, const T& alpha)
+{
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		x.Data()[i * x.GetStride()] *= alpha;
+} /*-------------------------------------------------------------------------*/
+
+template <class T, class A> // y = x
+void Copy(const TVectorSpan<A>& x, const TVectorSpan<T>& y)
+{
+	if (x.GetSize() != y.GetSize())
+		throw "not equal size";
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		y.Data()[i * y.GetStride()] = x.Data()[i * x.GetStride()];
+} /*-------------------------------------------------------------------------*/
+
+template <class A> // сумма элементов
+typename std::remove_const<A>::type Sum(const TVectorSpan<A>& x)
+{
+	typedef typename std::remove_const<A>::type E;
+	if (x.IsContiguous())
+		return VecSum<E>(x.Data(), x.GetSize());
+	E s = 0;
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		s += x.Data()[i * x.GetStride()];
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class A> // сумма модулей
+typename std::remove_const<A>::type NormL1(const TVectorSpan<A>& x)
+{
+	typedef typename std::remove_const<A>::type E;
+	if (x.IsContiguous())
+		return VecSumAbs<E>(x.Data(), x.GetSize());
+	E s = 0;
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		s += Abs(x.Data()[i * x.GetStride()]);
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class A> // евклидова норма
+double NormL2(const TVectorSpan<A>& x)
+{
+	return sqrt((double)Dot(x, x));
+} /*-------------------------------------------------------------------------*/
+
+template <class A> // максимум модуля
+typename std::remove_const<A>::type NormInf(const TVectorSpan<A>& x)
+{
+	typedef typename std::remove_const<A>::type E;
+	if (x.IsContiguous())
+		return VecMaxAbs<E>(x.Data(), x.GetSize());
+	E m = 0;
+	for (TIndex i = 0; i < x.GetSize(); i++)
+		m = (Abs(x.Data()[i * x.GetStride()]) > m) ? Abs(x.Data()[i * x.GetStride()]) : m;
+	return m;
+} /*-------------------------------------------------------------------------*/
+
+// Ядра над блоками: хранимая часть каждой строки блока - непрерывный участок.
+
+template <class A, class X, class Y> // y += B * x
+void MatVec(const TBlockView<A>& b, const TVectorSpan<X>& x, const TVectorSpan<Y>& y)
+{
+	if (x.GetSize() != b.GetCols() || y.GetSize() != b.GetRows())
+		throw "not equal size";
+	for (TIndex k = 0; k < b.GetRows(); k++)
+	{
+		const TIndex s = b.RowStart(k);
+		y.Data()[k * y.GetStride()] += Dot(b.Row(k), x.Sub(s, b.GetCols() - s));
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class A, class X, class Y> // y += B^T * x
+void MatTVec(const TBlockView<A>& b, const TVectorSpan<X>& x, const TVectorSpan<Y>& y)
+{
+	if (x.GetSize() != b.GetRows() || y.GetSize() != b.GetCols())
+		throw "not equal size";
+	for (TIndex k = 0; k < b.GetRows(); k++)
+	{
+		const TIndex s = b.RowStart(k);
+		Axpy((Y)x.Data()[k * x.GetStride()], b.Row(k), y.Sub(s, b.GetCols() - s));
+	}
+} /*-------------------------------------------------------------------------*/
+
+#endif
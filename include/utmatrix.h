@@ -8,12 +8,783 @@
 #ifndef __TMATRIX_H__
 #define __TMATRIX_H__
 
+// Нужен C++11 (<atomic> для счетчика ссылок TRefCount, перемещение и
+// шаблоны с переменным числом параметров в TVector::EmplaceBack):
+// Visual Studio 2015 или старше, см. README.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#error "utmatrix.h requires Visual Studio 2015 or newer (C++11)"
+#endif
+
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
 
 using namespace std;
 
-const int MAX_VECTOR_SIZE = 100000000;
-const int MAX_MATRIX_SIZE = 10000;
+// Размеры и индексы 64-битные (на 64-битной платформе): число элементов
+// вектора и хранимого треугольника матрицы может превышать 2^31. Тип знаковый,
+// чтобы разности индексов (pos - StartIndex < 0) оставались корректными.
+typedef ptrdiff_t TIndex;
+
+const TIndex MAX_VECTOR_SIZE = 100000000; // пределы по умолчанию
+const TIndex MAX_MATRIX_SIZE = 10000;
+
+inline TIndex& MaxVectorSize() // текущий предел размера вектора
+{
+	static TIndex limit = MAX_VECTOR_SIZE;
+	return limit;
+}
+
+inline TIndex& MaxMatrixSize() // текущий предел размера матрицы
+{
+	static TIndex limit = MAX_MATRIX_SIZE;
+	return limit;
+}
+
+// Ядра редукций по непрерывному массиву. Четыре независимых аккумулятора
+// разрывают цепочку зависимостей сложения и позволяют компилятору
+// векторизовать цикл.
+
+template <class T>
+inline T Abs(const T& x)
+{
+	return x < T(0) ? -x : x;
+}
+
+template <class T> // сумма элементов
+T VecSum(const T* p, TIndex n)
+{
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		s0 += p[i];
+		s1 += p[i + 1];
+		s2 += p[i + 2];
+		s3 += p[i + 3];
+	}
+	for (; i < n; i++)
+		s0 += p[i];
+	return (s0 + s1) + (s2 + s3);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сумма модулей
+T VecSumAbs(const T* p, TIndex n)
+{
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		s0 += Abs(p[i]);
+		s1 += Abs(p[i + 1]);
+		s2 += Abs(p[i + 2]);
+		s3 += Abs(p[i + 3]);
+	}
+	for (; i < n; i++)
+		s0 += Abs(p[i]);
+	return (s0 + s1) + (s2 + s3);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сумма квадратов
+T VecSumSq(const T* p, TIndex n)
+{
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		s0 += p[i] * p[i];
+		s1 += p[i + 1] * p[i + 1];
+		s2 += p[i + 2] * p[i + 2];
+		s3 += p[i + 3] * p[i + 3];
+	}
+	for (; i < n; i++)
+		s0 += p[i] * p[i];
+	return (s0 + s1) + (s2 + s3);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // максимум модуля
+T VecMaxAbs(const T* p, TIndex n)
+{
+	T m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		m0 = (Abs(p[i]) > m0) ? Abs(p[i]) : m0;
+		m1 = (Abs(p[i + 1]) > m1) ? Abs(p[i + 1]) : m1;
+		m2 = (Abs(p[i + 2]) > m2) ? Abs(p[i + 2]) : m2;
+		m3 = (Abs(p[i + 3]) > m3) ? Abs(p[i + 3]) : m3;
+	}
+	for (; i < n; i++)
+		m0 = (Abs(p[i]) > m0) ? Abs(p[i]) : m0;
+	m0 = (m1 > m0) ? m1 : m0;
+	m2 = (m3 > m2) ? m3 : m2;
+	return (m2 > m0) ? m2 : m0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // скалярное произведение
+T VecDot(const T* a, const T* b, TIndex n)
+{
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		s0 += a[i] * b[i];
+		s1 += a[i + 1] * b[i + 1];
+		s2 += a[i + 2] * b[i + 2];
+		s3 += a[i + 3] * b[i + 3];
+	}
+	for (; i < n; i++)
+		s0 += a[i] * b[i];
+	return (s0 + s1) + (s2 + s3);
+} /*-------------------------------------------------------------------------*/
+
+// Режим параллельных сумм.
+// REDUCE_FAST - частичные суммы потоков складываются в порядке их завершения,
+//   результат для вещественных T зависит от числа потоков.
+// REDUCE_REPRODUCIBLE - массив делится на блоки фиксированной длины
+//   REDUCE_BLOCK, суммы блоков складываются попарно по фиксированному дереву.
+//   Порядок сложений не зависит от числа потоков, поэтому результат побитово
+//   совпадает при любом их числе. Ядра Vec* задают порядок явно и не содержат
+//   интринсиков, так что при сборке без /fp:fast (-ffast-math) и без слияния
+//   a * b + c в FMA результат не зависит и от набора инструкций (SSE/AVX).
+//   Слияние запрещается явно: /fp:precise в MSVC (задано в проектах sln),
+//   -ffp-contract=off в gcc и clang (gcc по умолчанию сливает при -mfma
+//   и -march=native). Скалярное произведение и суммы считаются по
+//   логическим элементам вектора (без дополнения строк), поэтому одни и те
+//   же данные дают одинаковые частичные суммы во всех операциях.
+enum TReduceMode { REDUCE_FAST, REDUCE_REPRODUCIBLE };
+
+const int REDUCE_BLOCK = 4096;
+
+inline TReduceMode& ReduceMode() // текущий режим (по умолчанию REDUCE_FAST)
+{
+	static TReduceMode mode = REDUCE_FAST;
+	return mode;
+}
+
+template <class T> // попарная сумма a[0..n-1]; массив портится
+T PairwiseSum(T* a, TIndex n)
+{
+	if (n == 0)
+		return T(0);
+	for (TIndex step = 1; step < n; step *= 2)
+		for (TIndex i = 0; i + step < n; i += 2 * step)
+			a[i] += a[i + step];
+	return a[0];
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // параллельная редукция p[0..n-1] ядром kernel по блокам
+T BlockReduce(T (*kernel)(const T*, TIndex), const T* p, TIndex n)
+{
+	if (n <= REDUCE_BLOCK)
+		return kernel(p, n);
+	const TIndex nb = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+	if (ReduceMode() == REDUCE_FAST)
+	{
+		T s = 0;
+#pragma omp parallel for reduction(+:s) schedule(static)
+		for (TIndex k = 0; k < nb; k++)
+		{
+			const TIndex len = (k == nb - 1) ? n - k * REDUCE_BLOCK : REDUCE_BLOCK;
+			s += kernel(p + k * REDUCE_BLOCK, len);
+		}
+		return s;
+	}
+	T* part = new T[nb];
+#pragma omp parallel for schedule(static)
+	for (TIndex k = 0; k < nb; k++)
+	{
+		const TIndex len = (k == nb - 1) ? n - k * REDUCE_BLOCK : REDUCE_BLOCK;
+		part[k] = kernel(p + k * REDUCE_BLOCK, len);
+	}
+	T s = PairwiseSum(part, nb);
+	delete[] part;
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // параллельное скалярное произведение по блокам
+T BlockDot(const T* a, const T* b, TIndex n)
+{
+	if (n <= REDUCE_BLOCK)
+		return VecDot(a, b, n);
+	const TIndex nb = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+	if (ReduceMode() == REDUCE_FAST)
+	{
+		T s = 0;
+#pragma omp parallel for reduction(+:s) schedule(static)
+		for (TIndex k = 0; k < nb; k++)
+		{
+			const TIndex len = (k == nb - 1) ? n - k * REDUCE_BLOCK : REDUCE_BLOCK;
+			s += VecDot(a + k * REDUCE_BLOCK, b + k * REDUCE_BLOCK, len);
+		}
+		return s;
+	}
+	T* part = new T[nb];
+#pragma omp parallel for schedule(static)
+	for (TIndex k = 0; k < nb; k++)
+	{
+		const TIndex len = (k == nb - 1) ? n - k * REDUCE_BLOCK : REDUCE_BLOCK;
+		part[k] = VecDot(a + k * REDUCE_BLOCK, b + k * REDUCE_BLOCK, len);
+	}
+	T s = PairwiseSum(part, nb);
+	delete[] part;
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+// Компенсированное суммирование (Ogita, Rump, Oishi: Sum2/Dot2) для
+// вещественных T. Ошибки округления каждого сложения и умножения находятся
+// точно (TwoSum, TwoProduct) и накапливаются отдельно, результат как при
+// вычислении с удвоенной точностью. Умножение раскладывается через
+// fma, если определен UTMATRIX_FMA (нужен аппаратный FMA), иначе расщеплением
+// Деккера. Компилятор не должен переупорядочивать или сливать операции
+// (нельзя /fp:fast, -ffast-math).
+enum TSumMethod { SUM_FAST, SUM_COMPENSATED };
+
+template <class T> // s + e == a + b точно
+inline void TwoSum(T a, T b, T& s, T& e)
+{
+	s = a + b;
+	T z = s - a;
+	e = (a - (s - z)) + (b - z);
+}
+
+template <class T> // p + e == a * b точно
+inline void TwoProduct(T a, T b, T& p, T& e)
+{
+	p = a * b;
+#ifdef UTMATRIX_FMA
+	e = fma(a, b, -p);
+#else
+	static const T factor = T(ldexp(1.0, (numeric_limits<T>::digits + 1) / 2) + 1);
+	T c = factor * a;
+	T ah = c - (c - a), al = a - ah;
+	c = factor * b;
+	T bh = c - (c - b), bl = b - bh;
+	e = al * bl - (((p - ah * bh) - al * bh) - ah * bl);
+#endif
+}
+
+template <class T> // компенсированная сумма, возвращает s, ошибку в err
+T VecSum2(const T* p, TIndex n, T& err)
+{
+	T s0 = 0, s1 = 0, c0 = 0, c1 = 0, q0, q1;
+	TIndex i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		TwoSum(s0, p[i], s0, q0);
+		TwoSum(s1, p[i + 1], s1, q1);
+		c0 += q0;
+		c1 += q1;
+	}
+	for (; i < n; i++)
+	{
+		TwoSum(s0, p[i], s0, q0);
+		c0 += q0;
+	}
+	TwoSum(s0, s1, s0, q0);
+	err = (c0 + c1) + q0;
+	return s0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // компенсированное скалярное произведение (Dot2)
+T VecDot2(const T* a, const T* b, TIndex n, T& err)
+{
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0, c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+	T h0, h1, h2, h3, r0, r1, r2, r3, q0, q1, q2, q3;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		TwoProduct(a[i], b[i], h0, r0);
+		TwoProduct(a[i + 1], b[i + 1], h1, r1);
+		TwoProduct(a[i + 2], b[i + 2], h2, r2);
+		TwoProduct(a[i + 3], b[i + 3], h3, r3);
+		TwoSum(s0, h0, s0, q0);
+		TwoSum(s1, h1, s1, q1);
+		TwoSum(s2, h2, s2, q2);
+		TwoSum(s3, h3, s3, q3);
+		c0 += q0 + r0;
+		c1 += q1 + r1;
+		c2 += q2 + r2;
+		c3 += q3 + r3;
+	}
+	for (; i < n; i++)
+	{
+		TwoProduct(a[i], b[i], h0, r0);
+		TwoSum(s0, h0, s0, q0);
+		c0 += q0 + r0;
+	}
+	TwoSum(s0, s1, s0, q0);
+	TwoSum(s2, s3, s2, q2);
+	TwoSum(s0, s2, s0, q1);
+	err = ((c0 + c1) + (c2 + c3)) + ((q0 + q2) + q1);
+	return s0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сложение сумм блоков с их ошибками
+T CompensatedCombine(const T* part, const T* err, TIndex nb)
+{
+	T s = 0, c = 0, q;
+	for (TIndex k = 0; k < nb; k++)
+	{
+		TwoSum(s, part[k], s, q);
+		c += q + err[k];
+	}
+	return s + c;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // параллельная компенсированная сумма по блокам
+T BlockSum2(const T* p, TIndex n)
+{
+	const TIndex nb = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+	T* part = new T[2 * nb];
+	T* err = part + nb;
+#pragma omp parallel for schedule(static)
+	for (TIndex k = 0; k < nb; k++)
+	{
+		const TIndex len = (k == nb - 1) ? n - k * REDUCE_BLOCK : REDUCE_BLOCK;
+		part[k] = VecSum2(p + k * REDUCE_BLOCK, len, err[k]);
+	}
+	T s = CompensatedCombine(part, err, nb);
+	delete[] part;
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // параллельное компенсированное скалярное произведение
+T BlockDot2(const T* a, const T* b, TIndex n)
+{
+	const TIndex nb = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+	T* part = new T[2 * nb];
+	T* err = part + nb;
+#pragma omp parallel for schedule(static)
+	for (TIndex k = 0; k < nb; k++)
+	{
+		const TIndex len = (k == nb - 1) ? n - k * REDUCE_BLOCK : REDUCE_BLOCK;
+		part[k] = VecDot2(a + k * REDUCE_BLOCK, b + k * REDUCE_BLOCK, len, err[k]);
+	}
+	T s = CompensatedCombine(part, err, nb);
+	delete[] part;
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+// Сравнение массивов. Для целых типов равенство значений совпадает
+// с равенством байтов, и сравнение сводится к memcmp. Для остальных типов
+// (в т.ч. вещественных: -0.0 == 0.0, NaN != NaN) элементы сравниваются
+// блоками по CMP_BLOCK без ветвлений внутри блока, выход - после блока.
+
+const int CMP_BLOCK = 64;
+
+template <class T> struct TBitwiseComparable { static const bool value = false; };
+template <> struct TBitwiseComparable<bool> { static const bool value = true; };
+template <> struct TBitwiseComparable<char> { static const bool value = true; };
+template <> struct TBitwiseComparable<signed char> { static const bool value = true; };
+template <> struct TBitwiseComparable<unsigned char> { static const bool value = true; };
+template <> struct TBitwiseComparable<short> { static const bool value = true; };
+template <> struct TBitwiseComparable<unsigned short> { static const bool value = true; };
+template <> struct TBitwiseComparable<int> { static const bool value = true; };
+template <> struct TBitwiseComparable<unsigned int> { static const bool value = true; };
+template <> struct TBitwiseComparable<long> { static const bool value = true; };
+template <> struct TBitwiseComparable<unsigned long> { static const bool value = true; };
+template <> struct TBitwiseComparable<long long> { static const bool value = true; };
+template <> struct TBitwiseComparable<unsigned long long> { static const bool value = true; };
+
+template <class T> // a[0..n-1] == b[0..n-1]
+bool VecEqual(const T* a, const T* b, TIndex n)
+{
+	if (n == 0)
+		return true;
+	if (TBitwiseComparable<T>::value) // совпадение адресов - равенство только здесь: NaN != NaN
+		return a == b || memcmp(a, b, n * sizeof(T)) == 0;
+	TIndex i = 0;
+	for (; i + CMP_BLOCK <= n; i += CMP_BLOCK)
+	{
+		bool eq = true;
+		for (TIndex j = i; j < i + CMP_BLOCK; j++)
+			eq &= (a[j] == b[j]);
+		if (!eq)
+			return false;
+	}
+	for (; i < n; i++)
+		if (!(a[i] == b[i]))
+			return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+// Расстояние в ulp между вещественными числами: число представимых
+// значений между ними. Для прочих типов - модуль разности.
+inline long long UlpKey(double x)
+{
+	long long k;
+	memcpy(&k, &x, sizeof(k));
+	return (k < 0) ? -(k & 0x7fffffffffffffffLL) : k;
+}
+
+inline long long UlpKey(float x)
+{
+	int k;
+	memcpy(&k, &x, sizeof(k));
+	return (k < 0) ? -(long long)(k & 0x7fffffff) : k;
+}
+
+inline double UlpDistance(double a, double b)
+{
+	return fabs((double)UlpKey(a) - (double)UlpKey(b));
+}
+
+inline double UlpDistance(float a, float b)
+{
+	return fabs((double)UlpKey(a) - (double)UlpKey(b));
+}
+
+template <class T>
+double UlpDistance(const T& a, const T& b)
+{
+	return (double)Abs(a - b);
+}
+
+// a и b близки, если |a - b| <= absTol, или |a - b| <= relTol * max(|a|, |b|),
+// или между ними не больше ulps представимых значений
+template <class T>
+bool ApproxEqualElem(const T& a, const T& b, double absTol, double relTol, int ulps)
+{
+	if (a == b)
+		return true;
+	double d = (double)Abs(a - b);
+	double m = (double)((Abs(a) > Abs(b)) ? Abs(a) : Abs(b));
+	return d <= absTol || d <= relTol * m || (ulps > 0 && UlpDistance(a, b) <= ulps);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // поэлементное приближенное сравнение
+bool VecApproxEqual(const T* a, const T* b, TIndex n, double absTol, double relTol, int ulps)
+{
+	TIndex i = 0;
+	for (; i + CMP_BLOCK <= n; i += CMP_BLOCK)
+	{
+		// быстрая проверка блока по абсолютному допуску, без ветвлений
+		bool ok = true;
+		for (TIndex j = i; j < i + CMP_BLOCK; j++)
+			ok &= ((double)Abs(a[j] - b[j]) <= absTol);
+		if (ok)
+			continue;
+		for (TIndex j = i; j < i + CMP_BLOCK; j++)
+			if (!ApproxEqualElem(a[j], b[j], absTol, relTol, ulps))
+				return false;
+	}
+	for (; i < n; i++)
+		if (!ApproxEqualElem(a[i], b[i], absTol, relTol, ulps))
+			return false;
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+// Хеш содержимого. Значение зависит только от размера и логической
+// последовательности элементов (для матрицы - строк треугольника) и не
+// зависит от числа потоков, поэтому его можно сохранять между запусками.
+// Ядро - 4 независимые полосы в духе xxHash64: элемент k попадает в полосу
+// k % 4. Нули вещественных типов приводятся к +0, чтобы хеш был согласован
+// с operator== (-0.0 == 0.0).
+
+struct THash128
+{
+	unsigned long long Lo, Hi;
+	bool operator==(const THash128& h) const { return Lo == h.Lo && Hi == h.Hi; }
+	bool operator!=(const THash128& h) const { return !(*this == h); }
+};
+
+const unsigned long long HASH_P1 = 0x9E3779B185EBCA87ULL;
+const unsigned long long HASH_P2 = 0xC2B2AE3D27D4EB4FULL;
+const unsigned long long HASH_P3 = 0x165667B19E3779F9ULL;
+const unsigned long long HASH_P4 = 0x85EBCA77C2B2AE63ULL;
+const unsigned long long HASH_P5 = 0x27D4EB2F165667C5ULL;
+
+inline unsigned long long HashRotl(unsigned long long x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+inline unsigned long long HashRound(unsigned long long acc, unsigned long long w)
+{
+	return HashRotl(acc + w * HASH_P2, 31) * HASH_P1;
+}
+
+inline unsigned long long HashAvalanche(unsigned long long h)
+{
+	h ^= h >> 33;
+	h *= HASH_P2;
+	h ^= h >> 29;
+	h *= HASH_P3;
+	h ^= h >> 32;
+	return h;
+}
+
+template <class T>
+inline T HashNormalize(const T& x) { return x; }
+inline double HashNormalize(double x) { return (x == 0) ? 0.0 : x; }
+inline float HashNormalize(float x) { return (x == 0) ? 0.0f : x; }
+
+template <class T> // добавить байты элемента в полосу
+inline unsigned long long HashElem(unsigned long long acc, const T& x)
+{
+	T y = HashNormalize(x);
+	unsigned char b[sizeof(T)];
+	memcpy(b, &y, sizeof(T));
+	for (size_t off = 0; off < sizeof(T); off += 8)
+	{
+		unsigned long long w = 0;
+		memcpy(&w, b + off, (sizeof(T) - off < 8) ? sizeof(T) - off : 8);
+		acc = HashRound(acc, w);
+	}
+	return acc;
+}
+
+template <class T> // хеш массива p[0..n-1]
+THash128 HashArray(const T* p, TIndex n, unsigned long long seed)
+{
+	unsigned long long v0 = seed + HASH_P1 + HASH_P2, v1 = seed + HASH_P2;
+	unsigned long long v2 = seed, v3 = seed - HASH_P1;
+	TIndex i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		v0 = HashElem(v0, p[i]);
+		v1 = HashElem(v1, p[i + 1]);
+		v2 = HashElem(v2, p[i + 2]);
+		v3 = HashElem(v3, p[i + 3]);
+	}
+	if (i < n)
+		v0 = HashElem(v0, p[i]);
+	if (i + 1 < n)
+		v1 = HashElem(v1, p[i + 1]);
+	if (i + 2 < n)
+		v2 = HashElem(v2, p[i + 2]);
+	const unsigned long long len = (unsigned long long)n * HASH_P5;
+	THash128 h;
+	h.Lo = HashAvalanche(HashRotl(v0, 1) + HashRotl(v1, 7) + HashRotl(v2, 12) + HashRotl(v3, 18) + len);
+	h.Hi = HashAvalanche((v0 ^ HashRotl(v2, 17)) + (v1 ^ HashRotl(v3, 29)) + len * HASH_P4);
+	return h;
+} /*-------------------------------------------------------------------------*/
+
+// последовательное сложение хешей частей (блоков вектора, строк матрицы)
+inline THash128 HashFold(const THash128* part, TIndex n)
+{
+	THash128 h;
+	h.Lo = (unsigned long long)n + HASH_P5;
+	h.Hi = ~(unsigned long long)n - HASH_P3;
+	for (TIndex k = 0; k < n; k++)
+	{
+		h.Lo = HashRound(h.Lo, part[k].Lo);
+		h.Hi = HashRound(h.Hi, part[k].Hi);
+	}
+	h.Lo = HashAvalanche(h.Lo);
+	h.Hi = HashAvalanche(h.Hi ^ h.Lo);
+	return h;
+} /*-------------------------------------------------------------------------*/
+
+// Копирование при записи. Буферы, выделенные при включенном режиме,
+// получают счетчик ссылок, и копия такого вектора (в т.ч. строк матрицы)
+// разделяет с ним буфер за O(1) - независимо от режима в момент копирования.
+// Первый изменяющий доступ (неконстантные operator[], Get_pVector, ввод)
+// отделяет собственную копию буфера.
+// Счетчик атомарный: копии одного вектора можно передавать в разные потоки.
+typedef atomic<int> TRefCount;
+
+inline bool& CopyOnWrite() // текущий режим (по умолчанию выключен)
+{
+	static bool mode = false;
+	return mode;
+}
+
+// Выравнивание буферов. Буферы векторов в куче выделяются по границе
+// ALIGN_BYTES (строка кеша). В режиме PadRows() буфер вектора арифметического типа
+// дополняется нулями до ширины W = ALIGN_BYTES / sizeof(T): слева на
+// StartIndex % W элементов, справа - до длины, кратной W. Тогда столбец j
+// во всех строках матрицы имеет одно и то же выравнивание, а все строки
+// кончаются на одном столбце, кратном W, и ядра по строкам могут обходить
+// весь дополненный буфер (Get_pBase, GetExtent) с выровненного адреса
+// без пролога и остатка (так устроено умножение матриц). Элементы
+// дополнения всегда нулевые. Суммы и нормы считаются только по логическим
+// элементам: иначе дополнение сдвигает элементы между аккумуляторами
+// ядер и потоками, и дополненная и плотная матрицы округляются по-разному.
+const int ALIGN_BYTES = 64;
+
+inline bool& PadRows() // текущий режим (по умолчанию выключен)
+{
+	static bool mode = false;
+	return mode;
+}
+
+template <class T> // ширина выравнивания в элементах
+inline int AlignWidth()
+{
+	return (is_arithmetic<T>::value && ALIGN_BYTES % sizeof(T) == 0) ? ALIGN_BYTES / (int)sizeof(T) : 1;
+}
+
+inline void* AlignedAlloc(size_t bytes)
+{
+	if (bytes == 0)
+		bytes = ALIGN_BYTES;
+#ifdef _MSC_VER
+	void* p = _aligned_malloc(bytes, ALIGN_BYTES);
+#else
+	void* p = 0;
+	if (posix_memalign(&p, ALIGN_BYTES, bytes) != 0)
+		p = 0;
+#endif
+	if (p == 0)
+		throw bad_alloc();
+	return p;
+}
+
+inline void AlignedFree(void* p)
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+// подсказки компилятору: указатель выровнен, массивы не перекрываются
+#if defined(__GNUC__)
+#define ASSUME_ALIGNED(p) ((__typeof__(p))__builtin_assume_aligned((p), ALIGN_BYTES))
+#else
+#define ASSUME_ALIGNED(p) (p)
+#endif
+#define RESTRICT __restrict
+
+template <class T> // y += a * x; x, y выровнены на ALIGN_BYTES, n кратно AlignWidth<T>()
+void VecAxpyAligned(T a, const T* x, T* y, TIndex n)
+{
+	const int w = ALIGN_BYTES / sizeof(T); // константа: внутренний цикл разворачивается целиком
+	const T* RESTRICT px = ASSUME_ALIGNED(x);
+	T* RESTRICT py = ASSUME_ALIGNED(y);
+	for (TIndex j = 0; j < n; j += w)
+		for (int l = 0; l < w; l++)
+			py[j + l] += a * px[j + l];
+}
+
+template <class T> // y += a * x; x и y не перекрываются
+void VecAxpy(T a, const T* x, T* y, TIndex n)
+{
+	const T* RESTRICT px = x;
+	T* RESTRICT py = y;
+	for (TIndex i = 0; i < n; i++)
+		py[i] += a * px[i];
+}
+
+// Память больших матриц. Матрица арифметического типа, занимающая не меньше
+// LARGE_MIN_BYTES, в режиме LargePages() размещает все строки в одном блоке
+// страниц ОС (mmap в Linux, VirtualAlloc в Windows) вместо отдельного буфера
+// на строку: большие страницы (2 МБ) сокращают промахи TLB.
+// LARGE_TRANSPARENT - прозрачные большие страницы (madvise(MADV_HUGEPAGE)),
+// LARGE_EXPLICIT - заранее выделенные большие страницы (MAP_HUGETLB,
+// MEM_LARGE_PAGES), при их нехватке - как LARGE_TRANSPARENT,
+// LARGE_LAZY - обычные страницы без первого касания: память ОС уже нулевая,
+// страница отображается при первом обращении (разреженные матрицы, тесты
+// размеров больше доступной памяти).
+// Страница отображается на узел NUMA потока, который первым пишет в нее,
+// поэтому строки обнуляются параллельно полосами по ROW_BAND строк
+// с тем же распределением schedule(static, ROW_BAND), что и в ядрах по строкам.
+// Блок освобождается вместе с последней строкой в нем; строка, которой
+// нужен новый буфер, переходит в собственный буфер.
+enum TLargePages { LARGE_OFF, LARGE_TRANSPARENT, LARGE_EXPLICIT, LARGE_LAZY };
+
+const size_t LARGE_MIN_BYTES = 2 << 20;
+const size_t HUGE_PAGE_BYTES = 2 << 20;
+const int ROW_BAND = 16;
+
+inline TLargePages& LargePages() // текущий режим (по умолчанию LARGE_OFF)
+{
+	static TLargePages mode = LARGE_OFF;
+	return mode;
+}
+
+struct TPageBlock // заголовок блока страниц
+{
+	atomic<int> Count; // буферов в блоке
+	size_t Bytes;      // размер отображения
+};
+
+// Отображение и освобождение страниц ОС. Определены в src/tpages.cpp,
+// чтобы системные заголовки (windows.h, sys/mman.h) и их макросы не
+// попадали к пользователям utmatrix.h; файл компилируется вместе с
+// программой, использующей LargePages().
+void* PageAlloc(size_t& bytes); // bytes округляется до размера страницы
+void PageFree(void* p, size_t bytes);
+
+inline TPageBlock* NewPageBlock(size_t& bytes, int count) // заголовок занимает ALIGN_BYTES
+{
+	TPageBlock* b = (TPageBlock*)PageAlloc(bytes);
+	new (&b->Count) atomic<int>(count);
+	b->Bytes = bytes;
+	return b;
+}
+
+inline void ReleasePageBlock(TPageBlock* b)
+{
+	if (b->Count.fetch_sub(1) == 1)
+		PageFree(b, b->Bytes);
+}
+
+// Буфер вектора неарифметического типа (строки матрицы) содержит живые
+// объекты только в начале [0, Extent); остальная емкость - сырая память,
+// в которую элементы конструируются при росте (SetSize, PushBack), так что
+// перенос в больший буфер не создает и не уничтожает лишних объектов.
+
+template <class T> // выровненный буфер из n элементов; первые live конструируются T()
+T* NewBuffer(TIndex n, TIndex live)
+{
+	T* p = (T*)AlignedAlloc((size_t)n * sizeof(T));
+	if (!is_arithmetic<T>::value)
+		for (TIndex i = 0; i < live; i++)
+			new (p + i) T();
+	return p;
+}
+
+template <class T> // уничтожить первые live элементов и освободить буфер
+void DeleteBuffer(T* p, TIndex live)
+{
+	if (!is_arithmetic<T>::value)
+		for (TIndex i = 0; i < live; i++)
+			p[i].~T();
+	AlignedFree(p);
+}
+/*-------------------------------------------------------------------------*/
+
+// Малые векторы. Вектор арифметического типа из не более чем
+// SMALL_BYTES / sizeof(T) элементов хранится во встроенном буфере объекта
+// и не обращается к куче; в матрице так хранятся короткие последние строки
+// треугольника. Встроенный буфер не разделяется (копирование при записи
+// для него не нужно) и не используется в режиме PadRows() - дополненным
+// строкам нужно выравнивание ALIGN_BYTES. Емкость задается при сборке
+// макросом UTMATRIX_SMALL_BYTES (0 - отключить).
+#ifndef UTMATRIX_SMALL_BYTES
+#define UTMATRIX_SMALL_BYTES 64
+#endif
+
+const int SMALL_BYTES = UTMATRIX_SMALL_BYTES;
+
+template <class T> // емкость встроенного буфера в элементах
+inline TIndex SmallCapacity()
+{
+	return is_arithmetic<T>::value ? SMALL_BYTES / (TIndex)sizeof(T) : 0;
+}
+
+union TSmallBuffer // встроенный буфер, выровненный для любого арифметического типа
+{
+	unsigned char Bytes[SMALL_BYTES > 0 ? SMALL_BYTES : 1];
+	long double AlignFloat;
+	long long AlignInt;
+};
+/*-------------------------------------------------------------------------*/
 
 // Шаблон вектора
 template <class T>
@@ -21,23 +792,86 @@ class TVector
 {
 protected:
 	T* pVector;
-	int Size;       // размер вектора
-	int StartIndex; // индекс первого элемента вектора
+	TIndex Size;       // размер вектора
+	TIndex StartIndex; // индекс первого элемента вектора
+	TRefCount* pRef; // счетчик ссылок на буфер (0 - буфер не разделяется)
+	TIndex Lead;       // нулевых элементов дополнения перед pVector
+	TIndex Extent;     // длина данных вместе с дополнением, от pVector - Lead
+	TIndex Capacity;   // элементов буфера, начиная с pVector
+	int Width;         // ширина дополнения (1 - без дополнения)
+	TPageBlock* pBlock; // блок страниц, содержащий буфер (0 - собственный буфер)
+	TSmallBuffer Small; // встроенный буфер малого вектора
+
+	static void Layout(TIndex s, TIndex si, TIndex& lead, TIndex& extent, int& width); // раскладка s элементов с индекса si
+	void Allocate(TIndex s, TIndex si); // новый неразделяемый или разделяемый буфер
+	void Place(TPageBlock* b, T* base, TIndex s, TIndex si, bool touch); // буфер в блоке страниц
+	template <class> friend class TMatrix;
+	void Release();        // отказ от буфера
+	void Detach();         // собственная копия разделяемого буфера
+	void Relocate(TIndex cap); // перенос в новый буфер емкостью не меньше cap
+	void SetSize(TIndex s);    // новый размер в пределах емкости
+	void Grow();               // место еще для одного элемента
+	void Steal(TVector& v);    // забрать буфер v, v становится пустым
 public:
 
-	TVector(int s = 10, int si = 0);
+	TVector(TIndex s = 10, TIndex si = 0);
 	TVector(const TVector& v);                // конструктор копирования
+	TVector(TVector&& v);                     // конструктор перемещения
 	~TVector();
 	T* Get_pVector()
+	{
+		Detach();
+		return pVector;
+	}
+	const T* Get_pVector() const
 	{
 		return pVector;
 	}
-	int GetSize() { return Size; } // размер вектора
-	int GetStartIndex() { return StartIndex; } // индекс первого элемента
-	T& operator[](int pos);             // доступ
+	TIndex GetSize() const { return Size; } // размер вектора
+	TIndex GetStartIndex() const { return StartIndex; } // индекс первого элемента
+	T* Get_pBase()                       // начало дополненного буфера
+	{
+		Detach();
+		return pVector - Lead;
+	}
+	const T* Get_pBase() const
+	{
+		return pVector - Lead;
+	}
+	TIndex GetExtent() const { return Extent; } // длина дополненного буфера
+	bool IsPadded() const;                   // буфер разложен как в режиме PadRows()
+	bool IsPaged() const { return pBlock != 0; } // буфер в блоке страниц (LargePages)
+	bool IsSmall() const { return pVector == (const T*)Small.Bytes; } // буфер встроенный
+	T& operator[](TIndex pos);             // доступ
+	const T& operator[](TIndex pos) const; // доступ без отделения буфера
+	bool IsShared() const { return pRef != 0 && pRef->load() > 1; } // буфер разделяется с копией
 	bool operator==(const TVector& v) const;  // сравнение
 	bool operator!=(const TVector& v) const;  // сравнение
+	bool ApproxEqual(const TVector& v, double absTol, double relTol = 0, int ulps = 0) const; // сравнение с допуском
 	TVector& operator=(const TVector& v);     // присваивание
+	TVector& operator=(TVector&& v);          // присваивание перемещением
+
+	// изменение размера; элементы за концом емкости переносятся в новый буфер,
+	// емкость растет геометрически, поэтому добавление в конец - O(1) в среднем
+	TIndex GetCapacity() const { return Capacity; } // емкость
+	void Reserve(TIndex n);                   // емкость не меньше n
+	void Resize(TIndex n);                    // новый размер, новые элементы нулевые
+	void PushBack(const T& val);              // добавить в конец
+	template <class... A>
+	T& EmplaceBack(A&&... args)               // построить в конце
+	{
+		T tmp(std::forward<A>(args)...); // args могут ссылаться на элемент этого же вектора
+		Grow();
+		SetSize(Size + 1);
+		pVector[Size - 1] = std::move(tmp);
+		return pVector[Size - 1];
+	}
+	void PopBack();                           // удалить последний
+	void ShrinkToFit();                       // емкость по размеру
+
+	// хеш содержимого
+	THash128 Hash128() const;
+	unsigned long long Hash() const { return Hash128().Lo; }
 
 	// скалярные операции
 	TVector  operator+(const T& val);   // прибавить скаляр
@@ -48,56 +882,345 @@ public:
 	TVector  operator+(const TVector& v);     // сложение
 	TVector  operator-(const TVector& v);     // вычитание
 	T  operator*(const TVector& v);     // скалярное произведение
+	T  Dot(const TVector& v, TSumMethod method = SUM_FAST) const; // скалярное произведение
+	T  Sum(TSumMethod method = SUM_FAST) const;                    // сумма элементов
+
+	// нормы
+	T NormL1() const;       // сумма модулей
+	double NormL2() const;  // евклидова норма
+	T NormInf() const;      // максимум модуля
 
 	// ввод-вывод
 	friend istream& operator>>(istream& in, TVector& v)
 	{
-		for (int i = 0; i < v.Size; i++)
-			in >> v.pVector[i];
-		return in;
+		v.Detach();
+		for (TIndex i = 0; i < v.Size; i++)
+			in >> v.pVector[i];
+		return in;
+	}
+	friend ostream& operator<<(ostream& out, const TVector& v)
+	{
+		for (TIndex i = 0; i < v.Size; i++)
+			out << v.pVector[i] << ' ';
+		return out;
+	}
+};
+
+template <class T>
+TVector<T>::TVector(TIndex s, TIndex si)
+{
+	if (s < 0 || s > MaxVectorSize() || si < 0)
+		throw "wrong size";
+	Size = s;
+	StartIndex = si;
+	Allocate(Size, StartIndex);
+	for (TIndex i = 0; i < Size; i++)
+	{
+		pVector[i] = 0;
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> //конструктор копирования
+TVector<T>::TVector(const TVector<T>& v)
+{
+	Size = v.Size;
+	StartIndex = v.StartIndex;
+	if (v.pRef)
+	{
+		// разделяемый буфер
+		v.pRef->fetch_add(1);
+		pRef = v.pRef;
+		pVector = v.pVector;
+		Lead = v.Lead;
+		Extent = v.Extent;
+		Capacity = v.Capacity;
+		Width = v.Width;
+		pBlock = v.pBlock;
+		return;
+	}
+	Allocate(Size, StartIndex);
+	for (TIndex i = 0; i < Size; i++)
+	{
+		pVector[i] = v.pVector[i];
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // конструктор перемещения
+TVector<T>::TVector(TVector<T>&& v)
+{
+	Steal(v);
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+TVector<T>::~TVector()
+{
+	Release();
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::Layout(TIndex s, TIndex si, TIndex& lead, TIndex& extent, int& width)
+{
+	width = PadRows() ? AlignWidth<T>() : 1;
+	lead = si % width;
+	extent = (lead + s + width - 1) / width * width;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // буфер под s элементов, начиная с индекса si
+void TVector<T>::Allocate(TIndex s, TIndex si)
+{
+	pBlock = 0;
+	if (s <= SmallCapacity<T>() && !PadRows())
+	{
+		Lead = 0;
+		Extent = s;
+		Capacity = SmallCapacity<T>();
+		Width = 1;
+		pVector = (T*)Small.Bytes;
+		pRef = 0;
+		return;
+	}
+	Layout(s, si, Lead, Extent, Width);
+	Capacity = Extent - Lead;
+	T* base = NewBuffer<T>(Extent, Extent);
+	for (TIndex i = 0; i < Lead; i++)
+		base[i] = T(0);
+	for (TIndex i = Lead + s; i < Extent; i++)
+		base[i] = T(0);
+	pVector = base + Lead;
+	pRef = CopyOnWrite() ? new TRefCount(1) : 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // буфер освобождает последний владелец
+void TVector<T>::Release()
+{
+	if (pRef)
+	{
+		if (pRef->fetch_sub(1) != 1)
+			return;
+		delete pRef;
+	}
+	if (pBlock)
+		ReleasePageBlock(pBlock);
+	else if (!IsSmall())
+		DeleteBuffer(pVector - Lead, Extent);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // буфер base в блоке b, размеченный по Layout(s, si); touch - обнулить
+void TVector<T>::Place(TPageBlock* b, T* base, TIndex s, TIndex si, bool touch)
+{
+	Release();
+	Layout(s, si, Lead, Extent, Width);
+	Capacity = Extent - Lead;
+	Size = s;
+	StartIndex = si;
+	pBlock = b;
+	if (touch)
+		for (TIndex i = 0; i < Extent; i++)
+			base[i] = T(0);
+	pVector = base + Lead;
+	pRef = CopyOnWrite() ? new TRefCount(1) : 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::Detach()
+{
+	if (pRef == 0 || pRef->load() == 1)
+		return;
+	T* base = NewBuffer<T>(Lead + Capacity, 0);
+	const T* src = pVector - Lead;
+	for (TIndex i = 0; i < Extent; i++)
+	{
+		new (base + i) T(src[i]);
+	}
+	Release();
+	pVector = base + Lead;
+	pBlock = 0;
+	pRef = new TRefCount(1);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // буфер емкостью cap (не меньше Size) с той же раскладкой
+void TVector<T>::Relocate(TIndex cap)
+{
+	if (cap > MaxVectorSize())
+		throw "wrong size";
+	const bool shared = IsShared();
+	const TIndex total = (Lead + cap + Width - 1) / Width * Width;
+	T* base = NewBuffer<T>(total, 0);
+	T* src = pVector - Lead;
+	if (is_arithmetic<T>::value)
+		memcpy((void*)base, src, (size_t)Extent * sizeof(T));
+	else if (shared)
+		for (TIndex i = 0; i < Extent; i++)
+			new (base + i) T(src[i]);
+	else
+		for (TIndex i = 0; i < Extent; i++)
+			new (base + i) T(std::move(src[i]));
+	const bool counted = pRef != 0;
+	Release();
+	pVector = base + Lead;
+	Capacity = total - Lead;
+	pBlock = 0;
+	pRef = counted ? new TRefCount(1) : 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // хвост [s, Extent) после изменения размера заполняется нулями
+void TVector<T>::SetSize(TIndex s)
+{
+	T* base = pVector - Lead;
+	const TIndex e = (Lead + s + Width - 1) / Width * Width;
+	if (!is_arithmetic<T>::value) // без дополнения: живые элементы - ровно [0, s)
+	{
+		for (TIndex i = e; i < Extent; i++)
+			base[i].~T();
+		for (TIndex i = Extent; i < e; i++)
+			new (base + i) T(0);
+		Size = s;
+		Extent = e;
+		return;
+	}
+	const TIndex z = (Lead + Size > e) ? Lead + Size : e;
+	for (TIndex i = Lead + s; i < z; i++)
+		base[i] = T(0);
+	Size = s;
+	Extent = e;
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::Grow()
+{
+	if (Size < Capacity)
+	{
+		Detach();
+		return;
+	}
+	Relocate(Capacity < 4 ? 8 : 2 * Capacity);
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::Steal(TVector<T>& v)
+{
+	Size = v.Size;
+	StartIndex = v.StartIndex;
+	pRef = v.pRef;
+	Lead = v.Lead;
+	Extent = v.Extent;
+	Capacity = v.Capacity;
+	Width = v.Width;
+	pBlock = v.pBlock;
+	if (v.IsSmall())
+	{
+		pVector = (T*)Small.Bytes;
+		for (TIndex i = 0; i < Size; i++)
+			pVector[i] = v.pVector[i];
+	}
+	else
+		pVector = v.pVector;
+	// v - пустой вектор во встроенном буфере
+	v.pVector = (T*)v.Small.Bytes;
+	v.Size = v.Lead = v.Extent = 0;
+	v.Capacity = SmallCapacity<T>();
+	v.Width = 1;
+	v.pRef = 0;
+	v.pBlock = 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::Reserve(TIndex n)
+{
+	if (n > Capacity)
+		Relocate(n);
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::Resize(TIndex n)
+{
+	if (n < 0)
+		throw "wrong size";
+	if (n > Capacity)
+		Relocate((n < 2 * Capacity) ? 2 * Capacity : n);
+	else
+		Detach();
+	const TIndex s = Size;
+	SetSize(n);
+	for (TIndex i = s; i < n; i++)
+		pVector[i] = T(0);
+} /*-------------------------------------------------------------------------*/
+
+template <class T>
+void TVector<T>::PushBack(const T& val)
+{
+	if (Size < Capacity && Width == 1 && pRef == 0)
+	{
+		// частый случай: место есть, дополнения нет; элемент за Extent еще не сконструирован
+		new (pVector + Size) T(val);
+		Extent = ++Size;
+		return;
 	}
-	friend ostream& operator<<(ostream& out, const TVector& v)
+	if (Size == Capacity)
 	{
-		for (int i = 0; i < v.Size; i++)
-			out << v.pVector[i] << ' ';
-		return out;
+		T tmp(val); // val может быть элементом этого же вектора
+		Grow();
+		SetSize(Size + 1);
+		pVector[Size - 1] = tmp;
+		return;
 	}
-};
+	Detach();
+	SetSize(Size + 1);
+	pVector[Size - 1] = val;
+} /*-------------------------------------------------------------------------*/
 
 template <class T>
-TVector<T>::TVector(int s, int si)
+void TVector<T>::PopBack()
 {
-	if (s < 0 || s > MAX_VECTOR_SIZE || si < 0)
-		throw "wrong size";
-	Size = s;
-	StartIndex = si;
-	pVector = new T[Size];
-	for (int i = 0; i < Size; i++)
-	{
-		pVector[i] = 0;
-	}
+	if (Size == 0)
+		throw "empty vector";
+	Detach();
+	SetSize(Size - 1);
 } /*-------------------------------------------------------------------------*/
 
-template <class T> //конструктор копирования
-TVector<T>::TVector(const TVector<T>& v)
+template <class T>
+void TVector<T>::ShrinkToFit()
 {
-	Size = v.Size;
-	StartIndex = v.StartIndex;
-	pVector = new T[Size];
-	for (int i = 0; i < Size; i++)
+	if (Capacity == Extent - Lead || IsSmall())
+		return;
+	if (Width == 1 && Size <= SmallCapacity<T>())
 	{
-		pVector[i] = v.pVector[i];
+		T* dst = (T*)Small.Bytes;
+		for (TIndex i = 0; i < Size; i++)
+			dst[i] = pVector[i];
+		Release();
+		pVector = dst;
+		Lead = 0;
+		Extent = Size;
+		Capacity = SmallCapacity<T>();
+		pRef = 0;
+		pBlock = 0;
+		return;
 	}
+	Relocate(Extent - Lead);
 } /*-------------------------------------------------------------------------*/
 
 template <class T>
-TVector<T>::~TVector()
+bool TVector<T>::IsPadded() const
+{
+	const int w = AlignWidth<T>();
+	return Lead == StartIndex % w && Extent == (Lead + Size + w - 1) / w * w &&
+		(size_t)(pVector - Lead) % ALIGN_BYTES == 0;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // доступ
+T& TVector<T>::operator[](TIndex pos)
 {
-	delete[] pVector;
+	if (pos - StartIndex < 0 || pos - StartIndex >= Size)
+	{
+		throw exception("bad index");
+	}
+	Detach();
+	return pVector[pos - StartIndex];
 } /*-------------------------------------------------------------------------*/
 
 template <class T> // доступ
-T& TVector<T>::operator[](int pos)
+const T& TVector<T>::operator[](TIndex pos) const
 {
 	if (pos - StartIndex < 0 || pos - StartIndex >= Size)
 	{
@@ -113,14 +1236,7 @@ bool TVector<T>::operator==(const TVector& v) const
 	{
 		return false;
 	}
-	for (int i = 0; i < Size; i++)
-	{
-		if (v.pVector[i] != pVector[i])
-		{
-			return false;
-		}
-	}
-	return true;
+	return VecEqual(pVector, v.pVector, Size);
 } /*-------------------------------------------------------------------------*/
 
 template <class T> // сравнение
@@ -129,29 +1245,89 @@ bool TVector<T>::operator!=(const TVector& v) const
 	return !(*this == v);
 } /*-------------------------------------------------------------------------*/
 
+template <class T> // сравнение с допуском
+bool TVector<T>::ApproxEqual(const TVector& v, double absTol, double relTol, int ulps) const
+{
+	if (Size != v.Size)
+	{
+		return false;
+	}
+	return VecApproxEqual(pVector, v.pVector, Size, absTol, relTol, ulps);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // хеш содержимого; длинные векторы хешируются по блокам параллельно
+THash128 TVector<T>::Hash128() const
+{
+	if (Size <= REDUCE_BLOCK)
+		return HashArray(pVector, Size, (unsigned long long)Size);
+	const TIndex nb = (Size + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+	THash128* part = new THash128[nb];
+#pragma omp parallel for schedule(static)
+	for (TIndex k = 0; k < nb; k++)
+	{
+		const TIndex len = (k == nb - 1) ? Size - k * REDUCE_BLOCK : REDUCE_BLOCK;
+		part[k] = HashArray(pVector + k * REDUCE_BLOCK, len, (unsigned long long)k);
+	}
+	THash128 h = HashFold(part, nb);
+	delete[] part;
+	return h;
+} /*-------------------------------------------------------------------------*/
+
 template <class T> // присваивание
 TVector<T>& TVector<T>::operator=(const TVector& v)
 {
-	if (v != *this)
+	if (this == &v)
 	{
-		delete[] pVector;
-		pVector = new T[v.Size];
+		return *this;
 	}
-	Size = v.Size;
+	if (v.pRef)
+	{
+		v.pRef->fetch_add(1);
+		Release();
+		pRef = v.pRef;
+		pVector = v.pVector;
+		Lead = v.Lead;
+		Extent = v.Extent;
+		Capacity = v.Capacity;
+		Width = v.Width;
+		pBlock = v.pBlock;
+		Size = v.Size;
+		StartIndex = v.StartIndex;
+		return *this;
+	}
+	if (v.Size > Capacity || Lead != v.Lead || IsShared())
+	{
+		Release();
+		Allocate(v.Size, v.StartIndex);
+		Size = v.Size;
+	}
+	else
+		SetSize(v.Size);
 	StartIndex = v.StartIndex;
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
 		pVector[i] = v.pVector[i];
 	}
 	return *this;
 } /*-------------------------------------------------------------------------*/
 
+template <class T> // присваивание перемещением
+TVector<T>& TVector<T>::operator=(TVector<T>&& v)
+{
+	if (this != &v)
+	{
+		Release();
+		Steal(v);
+	}
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
 template <class T> // прибавить скаляр
 TVector<T> TVector<T>::operator+(const T& val)
 {
 
 	TVector<T> res(Size);
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
 		res.pVector[i] = val + pVector[i];
 	}
@@ -163,7 +1339,7 @@ template <class T> // вычесть скаляр
 TVector<T> TVector<T>::operator-(const T& val)
 {
 	TVector<T> Res(Size);
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
 		Res.pVector[i] = pVector[i] - val;
 	}
@@ -174,7 +1350,7 @@ template <class T> // умножить на скаляр
 TVector<T> TVector<T>::operator*(const T& val)
 {
 	TVector<T> Res(Size);
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
 		Res.pVector[i] = val * pVector[i];
 	}
@@ -189,7 +1365,7 @@ TVector<T> TVector<T>::operator+(const TVector<T>& v)
 		throw "not equal size";
 	}
 	TVector<T> Res(Size);
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
 		Res.pVector[i] = v.pVector[i] + pVector[i];
 	}
@@ -204,7 +1380,7 @@ TVector<T> TVector<T>::operator-(const TVector<T>& v)
 		throw  "not equal size";
 	}
 	TVector<T> res(Size);
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
 		res.pVector[i] = pVector[i] - v.pVector[i];
 	}
@@ -218,53 +1394,191 @@ T TVector<T>::operator*(const TVector<T>& v)
 	{
 		throw "not equal size";
 	}
-	T res = 0;
-	for (int i = 0; i < Size; i++)
+	return BlockDot(pVector, v.pVector, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // скалярное произведение выбранным методом
+T TVector<T>::Dot(const TVector<T>& v, TSumMethod method) const
+{
+	if (Size != v.Size)
 	{
-		res += v.pVector[i] * pVector[i];
+		throw "not equal size";
 	}
-	return res;
+	if (method == SUM_COMPENSATED)
+		return BlockDot2(pVector, v.pVector, Size);
+	return BlockDot(pVector, v.pVector, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сумма элементов выбранным методом
+T TVector<T>::Sum(TSumMethod method) const
+{
+	if (method == SUM_COMPENSATED)
+		return BlockSum2(pVector, Size);
+	return BlockReduce(VecSum<T>, pVector, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сумма модулей
+T TVector<T>::NormL1() const
+{
+	return BlockReduce(VecSumAbs<T>, pVector, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // евклидова норма
+double TVector<T>::NormL2() const
+{
+	return sqrt((double)BlockReduce(VecSumSq<T>, pVector, Size));
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // максимум модуля
+T TVector<T>::NormInf() const
+{
+	return VecMaxAbs(pVector, Size);
 } /*-------------------------------------------------------------------------*/
 
 
+// Диагональ верхнетреугольной матрицы.
+// DIAG_STORED - элементы диагонали произвольные,
+// DIAG_UNIT - единичная (треугольный множитель LU, нормированный базис),
+// DIAG_ZERO - нулевая (строго верхнетреугольная: смежность, расстояния).
+// SetDiagonal записывает значения в хранимую диагональ, поэтому любые
+// операции дают верный результат; ядра, знающие признак (решение систем,
+// умножение на вектор, обращение), не читают диагональ и не делят на нее.
+// Пока признак установлен, диагональные элементы не должны изменяться.
+enum TDiagonal { DIAG_STORED, DIAG_UNIT, DIAG_ZERO };
+
 // Верхнетреугольная матрица
 template <class T>
 class TMatrix : public TVector<TVector<T> >
 {
+protected:
+	TDiagonal Diag; // вид диагонали
 public:
-	TMatrix(int s = 10);
+	TMatrix(TIndex s = 10);
 	TMatrix(const TMatrix& mt);                    // копирование
+	TMatrix(TMatrix&& mt);                         // перемещение
 	TMatrix(const TVector<TVector<T> >& mt); // преобразование типа
+	TMatrix(TVector<TVector<T> >&& mt);      // преобразование типа с перемещением
+	const TVector<T>& Row(TIndex i) const { return pVector[i]; } // строка без проверки индекса
+	TDiagonal GetDiagonal() const { return Diag; } // вид диагонали
+	void SetDiagonal(TDiagonal d);                 // установить вид (и значения) диагонали
 	bool operator==(const TMatrix& mt) const;      // сравнение
 	bool operator!=(const TMatrix& mt) const;      // сравнение
+	bool ApproxEqual(const TMatrix& mt, double absTol, double relTol = 0, int ulps = 0) const; // сравнение с допуском
+	THash128 Hash128() const;                      // хеш содержимого
+	unsigned long long Hash() const { return Hash128().Lo; }
 	TMatrix& operator= (const TMatrix& mt);        // присваивание
+	TMatrix& operator= (TMatrix&& mt);             // присваивание перемещением
 	TMatrix  operator+ (const TMatrix& mt);        // сложение
 	TMatrix  operator- (const TMatrix& mt);        // вычитание
+	TMatrix  operator* (const TMatrix& mt) const;  // умножение
+	TMatrix  Inverse() const;                      // обратная матрица
+
+	// рост на один столбец: новый элемент в конце каждой строки и новая
+	// строка из диагонального элемента; емкость строк растет геометрически,
+	// поэтому переход от N к N + 1 стоит O(N) в среднем
+	void AppendColumn(const TVector<T>& c);        // c[i] - элемент (i, N), c[N] - диагональ (при DIAG_STORED)
+	void ReserveColumns(TIndex n);                 // емкость под порядок n без переносов
+	void ShrinkToFit();                            // емкость строк по размеру
+
+	// нормы и редукции по хранимому треугольнику
+	double NormF() const;                          // норма Фробениуса
+	T Norm1() const;                               // максимум суммы модулей по столбцам
+	T NormInf() const;                             // максимум суммы модулей по строкам
+	T NormMax() const;                             // максимум модуля элемента
+	T Sum() const;                                 // сумма элементов
+	T Min() const;                                 // минимальный элемент
+	T Max() const;                                 // максимальный элемент
+	void ArgMax(TIndex& row, TIndex& col) const;         // позиция максимального элемента
 
 	// ввод / вывод
 	friend istream& operator>>(istream& in, TMatrix& mt)
 	{
-		for (int i = 0; i < mt.Size; i++)
+		for (TIndex i = 0; i < mt.Size; i++)
 			in >> mt.pVector[i];
 		return in;
 	} 
 	friend ostream& operator<<(ostream& out, const TMatrix& mt)
 	{
-		for (int i = 0; i < mt.Size; i++)
+		for (TIndex i = 0; i < mt.Size; i++)
 			out << mt.pVector[i] << endl;
 		return out;
 	} 
 };
 /*-------------------------------------------------------------------------*/
+
+// Кеш результатов дорогих операций (умножение, обращение). Операторы
+// обращаются к кешу, только если он установлен через TMatrixCache<T>::Active();
+// ключ - вид операции, хеши и виды диагонали операндов. Совпадение ключа
+// не гарантирует совпадения операндов (коллизия хешей), поэтому кеш
+// получает сами операнды и сравнивает их с сохраненными (b = 0 у
+// одноместной операции). Реализация - в tmcache.h.
+enum TMatrixOp { MATRIX_MUL, MATRIX_INV };
+
+struct TMatrixKey
+{
+	int Op;
+	THash128 A, B;
+	TDiagonal DA, DB; // виды диагонали операндов
+	TMatrixKey() : Op(-1), DA(DIAG_STORED), DB(DIAG_STORED) { A.Lo = A.Hi = B.Lo = B.Hi = 0; }
+	TMatrixKey(int op, const THash128& a, const THash128& b, TDiagonal da = DIAG_STORED, TDiagonal db = DIAG_STORED) :
+		Op(op), A(a), B(b), DA(da), DB(db) {}
+	bool operator==(const TMatrixKey& k) const { return Op == k.Op && A == k.A && B == k.B && DA == k.DA && DB == k.DB; }
+};
+
+template <class T>
+class TMatrixCache
+{
+public:
+	virtual ~TMatrixCache() {}
+	virtual bool Find(const TMatrixKey& key, const TMatrix<T>& a, const TMatrix<T>* b, TMatrix<T>& res) = 0;
+	virtual void Store(const TMatrixKey& key, const TMatrix<T>& a, const TMatrix<T>* b, const TMatrix<T>& res) = 0;
+	static atomic<TMatrixCache*>& Active() // установленный кеш (по умолчанию нет); читается из потоков
+	{
+		static atomic<TMatrixCache*> cache(0);
+		return cache;
+	}
+};
+/*-------------------------------------------------------------------------*/
+
 template <class T>
-TMatrix<T>::TMatrix(int s) : TVector<TVector<T> >(s)
+TMatrix<T>::TMatrix(TIndex s) : TVector<TVector<T> >(s), Diag(DIAG_STORED)
 {
-	if (s > MAX_MATRIX_SIZE)
+	if (s > MaxMatrixSize())
 	{
 		throw exception("wrong size");
 	}
 	Size = s;
-	for (int i = 0; i < Size; i++)
+	if (LargePages() != LARGE_OFF && is_arithmetic<T>::value && Size > 0)
+	{
+		// смещения строк в блоке; строка начинается на границе ALIGN_BYTES
+		size_t* off = new size_t[Size + 1];
+		off[0] = ALIGN_BYTES;
+		for (TIndex i = 0; i < Size; i++)
+		{
+			TIndex lead, extent;
+			int width;
+			TVector<T>::Layout(Size - i, i, lead, extent, width);
+			const size_t bytes = (size_t)extent * sizeof(T);
+			off[i + 1] = off[i] + (bytes + ALIGN_BYTES - 1) / ALIGN_BYTES * ALIGN_BYTES;
+		}
+		if (off[Size] >= LARGE_MIN_BYTES)
+		{
+			size_t bytes = off[Size];
+			TPageBlock* block = NewPageBlock(bytes, (int)Size);
+			char* mem = (char*)block;
+			const bool touch = LargePages() != LARGE_LAZY;
+			// первое касание: полосу строк обнуляет поток, который будет ее обрабатывать
+#pragma omp parallel for schedule(static, ROW_BAND)
+			for (TIndex i = 0; i < Size; i++)
+			{
+				pVector[i].Place(block, (T*)(mem + off[i]), Size - i, i, touch);
+			}
+			delete[] off;
+			return;
+		}
+		delete[] off;
+	}
+	for (TIndex i = 0; i < Size; i++)
 	{
 		TVector<T>tmp(Size - i, i);
 		pVector[i] = tmp;
@@ -273,11 +1587,78 @@ TMatrix<T>::TMatrix(int s) : TVector<TVector<T> >(s)
 
 template <class T> // конструктор копирования
 TMatrix<T>::TMatrix(const TMatrix<T>& mt) :
-	TVector<TVector<T> >(mt){}
+	TVector<TVector<T> >(mt), Diag(mt.Diag) {}
+
+template <class T> // конструктор перемещения
+TMatrix<T>::TMatrix(TMatrix<T>&& mt) :
+	TVector<TVector<T> >(std::move(mt)), Diag(mt.Diag) {}
 
 template <class T> // конструктор преобразования типа
 TMatrix<T>::TMatrix(const TVector<TVector<T> >& mt) :
-	TVector<TVector<T> >(mt) {}
+	TVector<TVector<T> >(mt), Diag(DIAG_STORED) {}
+
+template <class T> // конструктор преобразования типа с перемещением
+TMatrix<T>::TMatrix(TVector<TVector<T> >&& mt) :
+	TVector<TVector<T> >(std::move(mt)), Diag(DIAG_STORED) {}
+
+template <class T> // установить вид диагонали
+void TMatrix<T>::SetDiagonal(TDiagonal d)
+{
+	if (d != DIAG_STORED)
+	{
+		for (TIndex i = 0; i < Size; i++)
+			pVector[i][i] = (d == DIAG_UNIT) ? T(1) : T(0);
+	}
+	Diag = d;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // добавить столбец
+void TMatrix<T>::AppendColumn(const TVector<T>& c)
+{
+	if (c.GetSize() != Size + 1)
+	{
+		throw "not equal size";
+	}
+	if (Size + 1 > MaxMatrixSize())
+	{
+		throw "wrong size";
+	}
+	const T* pc = c.Get_pVector();
+	TVector<TVector<T> >::Detach();
+	for (TIndex i = 0; i < Size; i++)
+	{
+		pVector[i].PushBack(pc[i]);
+	}
+	TVector<T> last(1, Size);
+	last[Size] = (Diag == DIAG_STORED) ? pc[Size] : (Diag == DIAG_UNIT) ? T(1) : T(0);
+	TVector<TVector<T> >::EmplaceBack(std::move(last));
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // емкость под порядок n
+void TMatrix<T>::ReserveColumns(TIndex n)
+{
+	if (n > MaxMatrixSize())
+	{
+		throw "wrong size";
+	}
+	TVector<TVector<T> >::Reserve(n);
+	TVector<TVector<T> >::Detach();
+	for (TIndex i = 0; i < Size; i++)
+	{
+		pVector[i].Reserve(n - i);
+	}
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // емкость строк по размеру
+void TMatrix<T>::ShrinkToFit()
+{
+	TVector<TVector<T> >::ShrinkToFit();
+	TVector<TVector<T> >::Detach();
+	for (TIndex i = 0; i < Size; i++)
+	{
+		pVector[i].ShrinkToFit();
+	}
+} /*-------------------------------------------------------------------------*/
 
 template <class T> // сравнение
 bool TMatrix<T>::operator==(const TMatrix<T>& m) const
@@ -286,7 +1667,11 @@ bool TMatrix<T>::operator==(const TMatrix<T>& m) const
 	{
 		return false;
 	}
-	for (size_t i = 0; i < Size; i++)
+	if (this == &m && TBitwiseComparable<T>::value) // NaN не равен себе, как в VecEqual
+	{
+		return true;
+	}
+	for (TIndex i = 0; i < Size; i++)
 	{
 		if (pVector[i] != m.pVector[i])
 		{
@@ -302,23 +1687,50 @@ bool TMatrix<T>::operator!=(const TMatrix<T>& mt) const
 	return!(mt == *this);
 } /*-------------------------------------------------------------------------*/
 
-template <class T> // присваивание
-TMatrix<T>& TMatrix<T>::operator=(const TMatrix<T>& m)
+template <class T> // хеш содержимого: хеши строк считаются параллельно
+THash128 TMatrix<T>::Hash128() const
 {
-	if (this == &m)
+	THash128* part = new THash128[Size];
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < Size; i++)
 	{
-		return *this;
+		part[i] = pVector[i].Hash128();
 	}
+	THash128 h = HashFold(part, Size);
+	delete[] part;
+	return h;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сравнение с допуском
+bool TMatrix<T>::ApproxEqual(const TMatrix<T>& m, double absTol, double relTol, int ulps) const
+{
 	if (Size != m.Size)
 	{
-		delete[]pVector;
-		Size = m.Size;
-		pVector = new TVector<T>[Size];
+		return false;
 	}
-	for (int i = 0; i < Size; i++)
+	for (TIndex i = 0; i < Size; i++)
 	{
-		pVector[i] = m.pVector[i];
+		if (!pVector[i].ApproxEqual(m.pVector[i], absTol, relTol, ulps))
+		{
+			return false;
+		}
 	}
+	return true;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // присваивание
+TMatrix<T>& TMatrix<T>::operator=(const TMatrix<T>& m)
+{
+	TVector<TVector<T> >::operator=(m);
+	Diag = m.Diag;
+	return *this;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // присваивание перемещением
+TMatrix<T>& TMatrix<T>::operator=(TMatrix<T>&& m)
+{
+	Diag = m.Diag;
+	TVector<TVector<T> >::operator=(std::move(m));
 	return *this;
 } /*-------------------------------------------------------------------------*/
 
@@ -336,6 +1748,309 @@ TMatrix<T> TMatrix<T>::operator-(const TMatrix<T>& m)
 
 } /*-------------------------------------------------------------------------*/
 
+template <class T> // умножение
+TMatrix<T> TMatrix<T>::operator*(const TMatrix<T>& m) const
+{
+	if (Size != m.Size)
+	{
+		throw "not equal size";
+	}
+	TMatrixCache<T>* cache = TMatrixCache<T>::Active();
+	TMatrixKey key;
+	if (cache)
+	{
+		key = TMatrixKey(MATRIX_MUL, Hash128(), m.Hash128(), Diag, m.Diag);
+		TMatrix<T> cached(0);
+		if (cache->Find(key, *this, &m, cached))
+			return cached;
+	}
+	TMatrix<T> res(Size);
+	// строка i результата = сумма A[i][k] * (строка k матрицы m), k >= i.
+	// Если обе строки дополнены (PadRows), проход идет от выровненного
+	// столбца k0 <= k до общего конца строк end: дополнение строки m нулевое,
+	// поэтому цикл не имеет ни пролога, ни остатка.
+	const int w = AlignWidth<T>();
+	const TIndex end = (Size + w - 1) / w * w;
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < Size; i++)
+	{
+		const T* a = Row(i).Get_pVector();
+		TVector<T>& ri = res.pVector[i];
+		T* c = ri.Get_pVector();
+		const bool padded = ri.IsPadded();
+		const TIndex i0 = i - i % w;
+		T* cb = padded ? c - (i - i0) : c; // столбец i0 строки i
+		for (TIndex k = i; k < Size; k++)
+		{
+			const T aik = a[k - i];
+			const TVector<T>& mk = m.Row(k);
+			if (padded && mk.IsPadded())
+			{
+				const TIndex k0 = k - k % w;
+				VecAxpyAligned(aik, mk.Get_pBase(), cb + (k0 - i0), end - k0);
+				continue;
+			}
+			const T* b = mk.Get_pVector();
+			T* ck = c + (k - i);
+			for (TIndex j = 0; j < Size - k; j++)
+				ck[j] += aik * b[j];
+		}
+		if (padded)
+		{
+			// aik * 0 не равно нулю для бесконечных aik: дополнение обнуляется заново
+			for (TIndex j = 0; j < i - i0; j++)
+				cb[j] = T(0);
+			for (TIndex j = Size - i0; j < end - i0; j++)
+				cb[j] = T(0);
+		}
+	}
+	if (Diag == DIAG_ZERO || m.Diag == DIAG_ZERO)
+		res.Diag = DIAG_ZERO; // диагональ произведения - произведение диагоналей
+	else if (Diag == DIAG_UNIT && m.Diag == DIAG_UNIT)
+		res.Diag = DIAG_UNIT;
+	if (cache)
+		cache->Store(key, *this, &m, res);
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // обратная матрица (верхнетреугольная)
+TMatrix<T> TMatrix<T>::Inverse() const
+{
+	TMatrixCache<T>* cache = TMatrixCache<T>::Active();
+	TMatrixKey key;
+	if (cache)
+	{
+		key = TMatrixKey(MATRIX_INV, Hash128(), THash128(), Diag);
+		TMatrix<T> cached(0);
+		if (cache->Find(key, *this, 0, cached))
+			return cached;
+	}
+	TMatrix<T> res(Size);
+	// строки снизу вверх: U[i][i] * X[i] = e_i - сумма(k > i) U[i][k] * X[k]
+	for (TIndex i = Size - 1; i >= 0; i--)
+	{
+		const T* u = Row(i).Get_pVector();
+		if (u[0] == T(0))
+		{
+			throw "singular matrix";
+		}
+		T* x = res.pVector[i].Get_pVector();
+		x[0] = 1;
+		for (TIndex k = i + 1; k < Size; k++)
+		{
+			const T uik = u[k - i];
+			const T* xk = res.pVector[k].Get_pVector();
+			T* xs = x + (k - i);
+			for (TIndex j = 0; j < Size - k; j++)
+				xs[j] -= uik * xk[j];
+		}
+		if (Diag != DIAG_UNIT)
+		{
+			for (TIndex j = 0; j < Size - i; j++)
+				x[j] /= u[0];
+		}
+	}
+	if (Diag == DIAG_UNIT)
+		res.Diag = DIAG_UNIT; // обратная к унитреугольной - унитреугольная
+	if (cache)
+		cache->Store(key, *this, 0, res);
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+// Редукции по матрице: строки обрабатываются ядрами Vec*, частичные
+// результаты строк собираются между потоками (OpenMP). Строки треугольника
+// разной длины, поэтому распределение динамическое. В режиме
+// REDUCE_REPRODUCIBLE суммы строк складываются попарно (см. RowReduce).
+
+template <class T> // сумма по строкам ядром kernel
+T RowReduce(T (*kernel)(const T*, TIndex), const TVector<T>* rows, TIndex n)
+{
+	if (ReduceMode() == REDUCE_FAST)
+	{
+		T s = 0;
+#pragma omp parallel for reduction(+:s) schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < n; i++)
+		{
+			s += kernel(rows[i].Get_pVector(), rows[i].GetSize());
+		}
+		return s;
+	}
+	T* part = new T[n];
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < n; i++)
+	{
+		part[i] = kernel(rows[i].Get_pVector(), rows[i].GetSize());
+	}
+	T s = PairwiseSum(part, n);
+	delete[] part;
+	return s;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // норма Фробениуса
+double TMatrix<T>::NormF() const
+{
+	return sqrt((double)RowReduce(VecSumSq<T>, pVector, Size));
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // максимум суммы модулей по столбцам
+T TMatrix<T>::Norm1() const
+{
+	// Столбцы делятся на полосы по 64; поток, владеющий полосой, проходит
+	// строки сверху вниз, поэтому порядок сложений в каждом столбце
+	// не зависит от числа потоков.
+	const int band = 64;
+	const TIndex nb = (Size + band - 1) / band;
+	T* col = new T[Size];
+	for (TIndex j = 0; j < Size; j++)
+		col[j] = 0;
+#pragma omp parallel for schedule(dynamic, 1)
+	for (TIndex b = nb - 1; b >= 0; b--)
+	{
+		const TIndex j0 = b * band;
+		const TIndex j1 = (j0 + band < Size) ? j0 + band : Size;
+		for (TIndex i = 0; i < j1; i++)
+		{
+			const T* row = Row(i).Get_pVector();
+			for (TIndex j = (i > j0) ? i : j0; j < j1; j++)
+				col[j] += Abs(row[j - i]);
+		}
+	}
+	T res = 0;
+	for (TIndex j = 0; j < Size; j++)
+		res = (col[j] > res) ? col[j] : res;
+	delete[] col;
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // максимум суммы модулей по строкам
+T TMatrix<T>::NormInf() const
+{
+	T res = 0;
+#pragma omp parallel
+	{
+		T loc = 0;
+#pragma omp for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < Size; i++)
+		{
+			T s = VecSumAbs(Row(i).Get_pVector(), Row(i).GetSize());
+			loc = (s > loc) ? s : loc;
+		}
+#pragma omp critical
+		res = (loc > res) ? loc : res;
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // максимум модуля элемента
+T TMatrix<T>::NormMax() const
+{
+	T res = 0;
+#pragma omp parallel
+	{
+		T loc = 0;
+#pragma omp for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < Size; i++)
+		{
+			T m = VecMaxAbs(Row(i).Get_pVector(), Row(i).GetSize());
+			loc = (m > loc) ? m : loc;
+		}
+#pragma omp critical
+		res = (loc > res) ? loc : res;
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // сумма элементов
+T TMatrix<T>::Sum() const
+{
+	return RowReduce(VecSum<T>, pVector, Size);
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // минимальный элемент
+T TMatrix<T>::Min() const
+{
+	if (Size == 0)
+		throw "empty matrix";
+	T res = Row(0).Get_pVector()[0];
+#pragma omp parallel
+	{
+		T loc = res;
+#pragma omp for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < Size; i++)
+		{
+			const T* row = Row(i).Get_pVector();
+			for (TIndex j = 0; j < Size - i; j++)
+				loc = (row[j] < loc) ? row[j] : loc;
+		}
+#pragma omp critical
+		res = (loc < res) ? loc : res;
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // максимальный элемент
+T TMatrix<T>::Max() const
+{
+	if (Size == 0)
+		throw "empty matrix";
+	T res = Row(0).Get_pVector()[0];
+#pragma omp parallel
+	{
+		T loc = res;
+#pragma omp for schedule(static, ROW_BAND)
+		for (TIndex i = 0; i < Size; i++)
+		{
+			const T* row = Row(i).Get_pVector();
+			for (TIndex j = 0; j < Size - i; j++)
+				loc = (row[j] > loc) ? row[j] : loc;
+		}
+#pragma omp critical
+		res = (loc > res) ? loc : res;
+	}
+	return res;
+} /*-------------------------------------------------------------------------*/
+
+template <class T> // позиция максимального элемента (первая в порядке строк)
+void TMatrix<T>::ArgMax(TIndex& row, TIndex& col) const
+{
+	if (Size == 0)
+		throw "empty matrix";
+	// максимум каждой строки ищется независимо, затем строки сравниваются по порядку
+	TIndex* pos = new TIndex[Size];
+#pragma omp parallel for schedule(static, ROW_BAND)
+	for (TIndex i = 0; i < Size; i++)
+	{
+		const T* r = Row(i).Get_pVector();
+		TIndex k = 0;
+		for (TIndex j = 1; j < Size - i; j++)
+			if (r[j] > r[k])
+				k = j;
+		pos[i] = k;
+	}
+	row = 0;
+	for (TIndex i = 1; i < Size; i++)
+		if (Row(i).Get_pVector()[pos[i]] > Row(row).Get_pVector()[pos[row]])
+			row = i;
+	col = row + pos[row];
+	delete[] pos;
+} /*-------------------------------------------------------------------------*/
+
+// хеш для неупорядоченных контейнеров
+namespace std
+{
+	template <class T>
+	struct hash<TVector<T> >
+	{
+		size_t operator()(const TVector<T>& v) const { return (size_t)v.Hash(); }
+	};
+
+	template <class T>
+	struct hash<TMatrix<T> >
+	{
+		size_t operator()(const TMatrix<T>& m) const { return (size_t)m.Hash(); }
+	};
+}
+
 // TVector О3 Л2 П4 С6
 // TMatrix О2 Л2 П3 С3
 #endif
@@ -0,0 +1,675 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// bench_utmatrix.cpp
+//
+// Замеры производительности операций над векторами и матрицами
+
+#include <iostream>
+#include <ctime>
+#include "utmatrix.h"
+#include "tqrupdate.h"
+#include "tcholesky.h"
+#include "tqr.h"
+#include "tcovar.h"
+#include "tdist.h"
+#include "tbmatrix.h"
+//---------------------------------------------------------------------------
+
+// время в миллисекундах на один вызов f, усредненное по reps повторам
+template <class F>
+double Measure(F f, int reps)
+{
+  clock_t start = clock();
+  for (int r = 0; r < reps; r++)
+    f();
+  return 1000.0 * (clock() - start) / CLOCKS_PER_SEC / reps;
+}
+//---------------------------------------------------------------------------
+
+volatile double sink; // результат замера, чтобы вызов не был удален
+
+struct DotCall
+{
+  TVector<double> *a, *b;
+  void operator()() { sink = (*a) * (*b); }
+};
+
+struct Dot2Call
+{
+  TVector<double> *a, *b;
+  void operator()() { sink = a->Dot(*b, SUM_COMPENSATED); }
+};
+
+struct NormFCall
+{
+  TMatrix<double> *m;
+  void operator()() { sink = m->NormF(); }
+};
+
+// стоимость воспроизводимых сумм по сравнению с быстрыми
+void BenchReduce()
+{
+  const int n = 10000000, size = 2000;
+  TVector<double> a(n), b(n);
+  for (int i = 0; i < n; i++)
+  {
+    a[i] = 1.0 / (i + 1);
+    b[i] = (i % 7) - 3.0;
+  }
+  TMatrix<double> m(size);
+  for (int i = 0; i < size; i++)
+    for (int j = i; j < size; j++)
+      m[i][j] = 1.0 / (i + j + 1);
+  DotCall dot = { &a, &b };
+  NormFCall normf = { &m };
+
+  cout << "reduce: dot n = " << n << ", NormF size = " << size << endl;
+  const TReduceMode modes[2] = { REDUCE_FAST, REDUCE_REPRODUCIBLE };
+  const char* names[2] = { "fast        ", "reproducible" };
+  for (int k = 0; k < 2; k++)
+  {
+    ReduceMode() = modes[k];
+    double tdot = Measure(dot, 10);
+    double tnorm = Measure(normf, 10);
+    cout << "  " << names[k] << "  dot " << tdot << " ms, NormF " << tnorm << " ms" << endl;
+  }
+  ReduceMode() = REDUCE_FAST;
+}
+//---------------------------------------------------------------------------
+
+// компенсированное скалярное произведение по сравнению с обычным
+void BenchDot2()
+{
+  const int n = 10000000;
+  TVector<double> a(n), b(n);
+  for (int i = 0; i < n; i++)
+  {
+    a[i] = 1.0 / (i + 1);
+    b[i] = (i % 7) - 3.0;
+  }
+  DotCall dot = { &a, &b };
+  Dot2Call dot2 = { &a, &b };
+
+  cout << "dot: n = " << n << endl;
+  cout << "  fast         " << Measure(dot, 10) << " ms" << endl;
+  cout << "  compensated  " << Measure(dot2, 10) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct MulCall
+{
+  TMatrix<double> *a, *b;
+  void operator()() { TMatrix<double> c = (*a) * (*b); sink = c[0][0]; }
+};
+
+// строки с выравниванием столбцов и дополнением (PadRows) по сравнению с упакованными
+void BenchAlign()
+{
+  const int size = 1000;
+  cout << "align: product and NormF size = " << size << endl;
+  const char* names[2] = { "packed", "padded" };
+  for (int k = 0; k < 2; k++)
+  {
+    PadRows() = (k == 1);
+    TMatrix<double> a(size), b(size);
+    for (int i = 0; i < size; i++)
+      for (int j = i; j < size; j++)
+      {
+        a[i][j] = 1.0 / (i + j + 1);
+        b[i][j] = (j % 7) - 3.0;
+      }
+    MulCall mul = { &a, &b };
+    NormFCall normf = { &a };
+    double tmul = Measure(mul, 3);
+    double tnorm = Measure(normf, 50);
+    cout << "  " << names[k] << "  product " << tmul << " ms, NormF " << tnorm << " ms" << endl;
+  }
+  PadRows() = false;
+}
+//---------------------------------------------------------------------------
+
+struct CreateCall
+{
+  int size;
+  void operator()() { TMatrix<double> m(size); sink = m.NormF(); }
+};
+
+struct SumCall
+{
+  TMatrix<double> *m;
+  void operator()() { sink = m->Sum(); }
+};
+
+// строки в одном блоке больших страниц по сравнению с отдельными буферами строк
+void BenchPages()
+{
+  const int size = 8000;
+  cout << "pages: create and Sum size = " << size << endl;
+  const TLargePages modes[2] = { LARGE_OFF, LARGE_TRANSPARENT };
+  const char* names[2] = { "rows    ", "one block" };
+  for (int k = 0; k < 2; k++)
+  {
+    LargePages() = modes[k];
+    CreateCall create = { size };
+    double tcreate = Measure(create, 3);
+    TMatrix<double> m(size);
+    for (int i = 0; i < size; i++)
+      for (int j = i; j < size; j += 3)
+        m[i][j] = 1.0 / (i + j + 1);
+    SumCall sum = { &m };
+    double tsum = Measure(sum, 20);
+    cout << "  " << names[k] << "  create " << tcreate << " ms, Sum " << tsum << " ms" << endl;
+  }
+  LargePages() = LARGE_OFF;
+}
+//---------------------------------------------------------------------------
+
+struct SmallCall
+{
+  TVector<double> *v;
+  void operator()()
+  {
+    double s = 0;
+    for (int k = 0; k < 100000; k++)
+    {
+      TVector<double> t(*v);
+      s += t[0];
+    }
+    sink = s;
+  }
+};
+
+// короткие векторы и матрицы: встроенный буфер вместо кучи
+void BenchSmall()
+{
+  const int size = 100;
+  TVector<double> v(4);
+  SmallCall copy = { &v };
+  CreateCall create = { size };
+  cout << "small: 100000 copies of 4-element vector, create size = " << size << endl;
+  cout << "  copies " << Measure(copy, 10) << " ms, create " << Measure(create, 1000) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct AppendCall
+{
+  int n;
+  void operator()()
+  {
+    TVector<double> v(0);
+    for (int i = 0; i < n; i++)
+      v.PushBack(i);
+    sink = v[n - 1];
+  }
+};
+
+// добавление в конец с геометрическим ростом емкости
+void BenchAppend()
+{
+  AppendCall append = { 10000000 };
+  cout << "append: " << append.n << " PushBack" << endl;
+  cout << "  " << Measure(append, 3) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct GrowCall
+{
+  int size;
+  bool rebuild; // новая матрица порядка N + 1 с копированием на каждом шаге
+  void operator()()
+  {
+    TMatrix<double> m(0);
+    for (int n = 0; n < size; n++)
+    {
+      TVector<double> c(n + 1);
+      for (int i = 0; i <= n; i++)
+        c[i] = 1.0 / (i + n + 1);
+      if (!rebuild)
+      {
+        m.AppendColumn(c);
+        continue;
+      }
+      TMatrix<double> g(n + 1);
+      for (int i = 0; i < n; i++)
+        for (int j = i; j < n; j++)
+          g[i][j] = m[i][j];
+      for (int i = 0; i <= n; i++)
+        g[i][n] = c[i];
+      m = g;
+    }
+    sink = m[0][size - 1];
+  }
+};
+
+// рост матрицы по столбцу: AppendColumn по сравнению с пересборкой
+void BenchGrow()
+{
+  const int size = 1000;
+  GrowCall append = { size, false }, rebuild = { size, true };
+  cout << "grow: 0 -> " << size << " by columns" << endl;
+  cout << "  AppendColumn " << Measure(append, 3) << " ms, rebuild " << Measure(rebuild, 1) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct UpdateCall
+{
+  TMatrix<double> *r;
+  TVector<double> *x;
+  void operator()()
+  {
+    RankOneUpdate(*r, *x);
+    RankOneDowndate(*r, *x);
+  }
+};
+
+// обновление и понижение ранга R по сравнению с одним проходом по R (Sum)
+void BenchUpdate()
+{
+  const int size = 2000;
+  TMatrix<double> r(size);
+  TVector<double> x(size);
+  for (int i = 0; i < size; i++)
+  {
+    x[i] = 1.0 / (i + 1);
+    for (int j = i; j < size; j++)
+      r[i][j] = (i == j) ? 2.0 + i : 1.0 / (i + j + 1);
+  }
+  UpdateCall update = { &r, &x };
+  SumCall sum = { &r };
+  cout << "update: size = " << size << endl;
+  cout << "  update + downdate " << Measure(update, 10) << " ms, Sum " << Measure(sum, 10) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct SymvCall
+{
+  TSymMatrix<double> *a;
+  TVector<double> *x;
+  void operator()() { sink = MatVec(*a, *x)[0]; }
+};
+
+struct DenseMatVecCall
+{
+  TDenseMatrix<double> *a;
+  TVector<double> *x;
+  void operator()()
+  {
+    const TIndex n = a->GetRows();
+    TVector<double> y(n);
+    for (TIndex i = 0; i < n; i++)
+      y[i] = VecDot(a->Get_pMem() + i * n, x->Get_pVector(), n);
+    sink = y[0];
+  }
+};
+
+// SYMV по треугольному хранилищу по сравнению с полной плотной копией
+void BenchSymv()
+{
+  const int size = 4000;
+  TSymMatrix<double> a(size);
+  TDenseMatrix<double> d(size, size);
+  TVector<double> x(size);
+  for (int i = 0; i < size; i++)
+  {
+    x[i] = 1.0 / (i + 1);
+    for (int j = i; j < size; j++)
+      a(i, j) = d(i, j) = d(j, i) = 1.0 / (i + j + 1);
+  }
+  SymvCall symv = { &a, &x };
+  DenseMatVecCall dense = { &d, &x };
+  cout << "symv: size = " << size << endl;
+  cout << "  triangle " << Measure(symv, 20) << " ms, dense " << Measure(dense, 20) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct CholCall
+{
+  TSymMatrix<double> *a;
+  int variant; // 0 - без блоков, 1 - блочное, 2 - задачи
+  void operator()()
+  {
+    TMatrix<double> u(0);
+    if (variant == 1)
+      CholeskyBlocked(*a, u);
+    else if (variant == 2)
+      CholeskyTasks(*a, u);
+    else
+    {
+      const TIndex n = a->GetSize();
+      double value;
+      double** r = CholRows(*a, u);
+      CholPanel(r, 0, n, n, value);
+      delete[] r;
+    }
+    sink = u[0][0];
+  }
+};
+
+// разложение Холецкого: одна полоса на всю матрицу, блочное, задачами
+void BenchCholesky()
+{
+  const int size = 2000;
+  TSymMatrix<double> a(size);
+  for (int i = 0; i < size; i++)
+    for (int j = i; j < size; j++)
+      a(i, j) = (i == j) ? 2.0 + i : 1.0 / (i + j + 1);
+  const char* names[3] = { "unblocked", "blocked  ", "tasks    " };
+  const double flops = (double)size * size * size / 3;
+  cout << "cholesky: size = " << size << endl;
+  for (int v = 0; v < 3; v++)
+  {
+    CholCall chol = { &a, v };
+    double t = Measure(chol, 2);
+    cout << "  " << names[v] << " " << t << " ms, " << flops / t / 1e6 << " GFLOP/s" << endl;
+  }
+}
+//---------------------------------------------------------------------------
+
+struct QRCall
+{
+  TDenseMatrix<double> *a;
+  int variant; // 0 - без блоков, 1 - блочное WY, 2 - TSQR
+  void operator()()
+  {
+    if (variant == 2)
+    {
+      sink = TSQR(*a)[0][0];
+      return;
+    }
+    TDenseMatrix<double> work(*a);
+    TMatrix<double> r(0);
+    if (variant == 1)
+      HouseholderQR(work, r);
+    else
+    {
+      double* tau = new double[a->GetCols()];
+      QRPanel(work.Get_pMem(), work.RowStride(), work.ColStride(), work.GetRows(), 0, work.GetCols(), tau);
+      delete[] tau;
+    }
+    sink = work(0, 0);
+  }
+};
+
+// QR высокой матрицы: одна панель на все столбцы, блочное WY, TSQR
+void BenchQR()
+{
+  const int rows = 8000, cols = 400;
+  TDenseMatrix<double> a(rows, cols);
+  for (int i = 0; i < rows; i++)
+    for (int j = 0; j < cols; j++)
+      a(i, j) = ((i == j) ? 3.0 : 0.0) + 1.0 / (i + 2 * j + 1);
+  const char* names[3] = { "unblocked", "blocked  ", "tsqr     " };
+  const double flops = 2.0 * rows * cols * cols - 2.0 * cols * cols * cols / 3;
+  cout << "qr: " << rows << " x " << cols << endl;
+  for (int v = 0; v < 3; v++)
+  {
+    QRCall qr = { &a, v };
+    double t = Measure(qr, 1);
+    cout << "  " << names[v] << " " << t << " ms, " << flops / t / 1e6 << " GFLOP/s" << endl;
+  }
+}
+//---------------------------------------------------------------------------
+
+struct GramCall
+{
+  TDenseMatrix<double> *a;
+  bool full; // полное произведение A^T A по строкам A и копия верхнего треугольника
+  void operator()()
+  {
+    const TIndex k = a->GetRows(), n = a->GetCols();
+    if (!full)
+    {
+      sink = Gram(*a)[0][0];
+      return;
+    }
+    TDenseMatrix<double> p(n, n);
+    const double* pa = a->Get_pMem();
+    double* pp = p.Get_pMem();
+    for (TIndex r = 0; r < k; r++)
+      for (TIndex i = 0; i < n; i++)
+      {
+        const double ari = pa[r * n + i];
+        for (TIndex j = 0; j < n; j++)
+          pp[i * n + j] += ari * pa[r * n + j];
+      }
+    TMatrix<double> c(n);
+    for (TIndex i = 0; i < n; i++)
+      for (TIndex j = i; j < n; j++)
+        c[i][j] = pp[i * n + j];
+    sink = c[0][0];
+  }
+};
+
+// A^T A: SYRK в треугольник по сравнению с полным произведением и копией
+void BenchGram()
+{
+  const int rows = 2000, cols = 1000;
+  TDenseMatrix<double> a(rows, cols);
+  for (int i = 0; i < rows; i++)
+    for (int j = 0; j < cols; j++)
+      a(i, j) = 1.0 / (i + j + 1);
+  GramCall syrk = { &a, false }, full = { &a, true };
+  const double flops = (double)rows * cols * cols; // FLOP треугольника
+  double ts = Measure(syrk, 1), tf = Measure(full, 1);
+  cout << "gram: " << rows << " x " << cols << endl;
+  cout << "  syrk " << ts << " ms (" << flops / ts / 1e6 << " GFLOP/s), full product " << tf << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct CovCall
+{
+  int size, count;
+  bool batched; // пакеты и SYRK или обновление Велфорда ранга 1 на каждое наблюдение
+  void operator()()
+  {
+    TVector<double> x(size);
+    if (batched)
+    {
+      TCovariance<double> c(size);
+      for (int k = 0; k < count; k++)
+      {
+        for (int j = 0; j < size; j++)
+          x[j] = (k * 31 + j * 17) % 101;
+        c.Add(x);
+      }
+      sink = c.Covariance()[0][0];
+      return;
+    }
+    TVector<double> mean(size), d(size);
+    TMatrix<double> m2(size);
+    for (int k = 0; k < count; k++)
+    {
+      for (int j = 0; j < size; j++)
+      {
+        x[j] = (k * 31 + j * 17) % 101;
+        d[j] = x[j] - mean[j];
+        mean[j] += d[j] / (k + 1);
+      }
+      for (int i = 0; i < size; i++)
+      {
+        double* ri = m2[i].Get_pVector();
+        const double di = d[i] * k / (k + 1);
+        for (int j = i; j < size; j++)
+          ri[j - i] += di * d[j];
+      }
+    }
+    sink = m2[0][0];
+  }
+};
+
+// ковариация потока: пакеты и SYRK по сравнению с Велфордом по одному наблюдению
+void BenchCovariance()
+{
+  CovCall batched = { 500, 20000, true }, welford = { 500, 20000, false };
+  cout << "covariance: " << batched.count << " samples of size " << batched.size << endl;
+  cout << "  batched " << Measure(batched, 1) << " ms, welford " << Measure(welford, 1) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct DistCall
+{
+  TDenseMatrix<double> *x;
+  TDistance metric;
+  bool direct; // разность координат для каждой пары
+  void operator()()
+  {
+    if (!direct)
+    {
+      sink = Distances(*x, metric)[0][1];
+      return;
+    }
+    const TIndex n = x->GetRows(), d = x->GetCols();
+    const double* px = x->Get_pMem();
+    TMatrix<double> dist(n);
+    for (TIndex i = 0; i < n; i++)
+    {
+      double* di = dist[i].Get_pVector();
+      for (TIndex j = i + 1; j < n; j++)
+      {
+        double s = 0;
+        for (TIndex k = 0; k < d; k++)
+          s += (px[i * d + k] - px[j * d + k]) * (px[i * d + k] - px[j * d + k]);
+        di[j - i] = sqrt(s);
+      }
+    }
+    sink = dist[0][1];
+  }
+};
+
+// матрица расстояний: SYRK и |x|^2 + |y|^2 - 2 x.y по сравнению с парами
+void BenchDistances()
+{
+  const int size = 4000, dim = 64;
+  TDenseMatrix<double> x(size, dim);
+  for (int i = 0; i < size; i++)
+    for (int j = 0; j < dim; j++)
+      x(i, j) = ((i * 13 + j * 7) % 17) * 0.5;
+  DistCall gram = { &x, DIST_EUCLIDEAN, false }, direct = { &x, DIST_EUCLIDEAN, true }, l1 = { &x, DIST_MANHATTAN, false };
+  cout << "distances: " << size << " points of size " << dim << endl;
+  cout << "  euclidean " << Measure(gram, 1) << " ms, direct " << Measure(direct, 1) << " ms, manhattan " << Measure(l1, 1) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct CondensedCall
+{
+  TDenseMatrix<double> *x;
+  bool condensed; // без диагонали, одним буфером
+  void operator()()
+  {
+    if (!condensed)
+    {
+      sink = Distances(*x)[0][1];
+      return;
+    }
+    TCondensedMatrix<double> dist(0);
+    Distances(*x, dist);
+    sink = dist(0, 1);
+  }
+};
+
+struct CondensedMatVecCall
+{
+  TCondensedMatrix<double> *c;
+  TMatrix<double> *m;
+  TVector<double> *x;
+  void operator()()
+  {
+    sink = c ? MatVec(*c, *x)[0] : MatVec(*m, *x)[0];
+  }
+};
+
+// сжатое хранилище строго верхнего треугольника по сравнению с TMatrix
+void BenchCondensed()
+{
+  const int size = 4000, dim = 64;
+  TDenseMatrix<double> x(size, dim);
+  for (int i = 0; i < size; i++)
+    for (int j = 0; j < dim; j++)
+      x(i, j) = ((i * 13 + j * 7) % 17) * 0.5;
+  CondensedCall full = { &x, false }, cond = { &x, true };
+  const double mfull = ((double)size * (size + 1) / 2 * sizeof(double) + (double)size * sizeof(TVector<double>)) / 1048576;
+  const double mcond = (double)size * (size - 1) / 2 * sizeof(double) / 1048576;
+  cout << "condensed: distances of " << size << " points, " << mfull << " MB -> " << mcond << " MB" << endl;
+  cout << "  TMatrix " << Measure(full, 1) << " ms, condensed " << Measure(cond, 1) << " ms" << endl;
+  TMatrix<double> m = Distances(x);
+  TCondensedMatrix<double> c(m);
+  TVector<double> v(size);
+  for (int i = 0; i < size; i++)
+    v[i] = i % 3;
+  CondensedMatVecCall mvfull = { 0, &m, &v }, mvcond = { &c, 0, &v };
+  cout << "  matvec: TMatrix " << Measure(mvfull, 20) << " ms, condensed " << Measure(mvcond, 20) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+struct BitCall
+{
+  TBitMatrix *a, *b;
+  TMatrix<int> *ia, *ib;
+  int op; // 0 - объединение, 1 - произведение, 2 - замыкание
+  void operator()()
+  {
+    if (a)
+    {
+      if (op == 0)
+        sink = (double)(*a | *b).Count();
+      else if (op == 1)
+        sink = (double)(*a * *b).Count();
+      else
+        sink = (double)a->Closure().Count();
+      return;
+    }
+    sink = (op == 0) ? (*ia + *ib)[0][1] : (*ia * *ib)[0][1];
+  }
+};
+
+// булева матрица по битам по сравнению с TMatrix<int>
+void BenchBits()
+{
+  const int size = 2000;
+  TBitMatrix a(size), b(size);
+  TMatrix<int> ia(size), ib(size);
+  for (int i = 0; i < size; i++)
+    for (int j = i; j < size; j++)
+    {
+      if ((i * 7 + j * 13) % 29 == 0)
+      {
+        a.Set(i, j);
+        ia[i][j] = 1;
+      }
+      if ((i * 11 + j * 3) % 31 == 0)
+      {
+        b.Set(i, j);
+        ib[i][j] = 1;
+      }
+    }
+  const double mbits = (double)(size / 64 + 1) * (size + 64) / 2 * sizeof(TBitWord) / 1048576;
+  const double mint = (double)size * (size + 1) / 2 * sizeof(int) / 1048576;
+  BitCall bor = { &a, &b, 0, 0, 0 }, bmul = { &a, &b, 0, 0, 1 }, bcl = { &a, 0, 0, 0, 2 };
+  BitCall ior = { 0, 0, &ia, &ib, 0 }, imul = { 0, 0, &ia, &ib, 1 };
+  cout << "bits: order " << size << ", " << mint << " MB as int -> " << mbits << " MB" << endl;
+  cout << "  or " << Measure(bor, 20) << " ms (int add " << Measure(ior, 5) << " ms), product "
+       << Measure(bmul, 3) << " ms (int " << Measure(imul, 1) << " ms), closure " << Measure(bcl, 3) << " ms" << endl;
+}
+//---------------------------------------------------------------------------
+
+int main()
+{
+  BenchReduce();
+  BenchDot2();
+  BenchAlign();
+  BenchPages();
+  BenchSmall();
+  BenchAppend();
+  BenchGrow();
+  BenchUpdate();
+  BenchSymv();
+  BenchCholesky();
+  BenchQR();
+  BenchGram();
+  BenchCovariance();
+  BenchDistances();
+  BenchCondensed();
+  BenchBits();
+  return 0;
+}
+//---------------------------------------------------------------------------
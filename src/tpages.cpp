@@ -0,0 +1,58 @@
+﻿// ННГУ, ВМК, Курс "Методы программирования-2", С++, ООП
+//
+// tpages.cpp
+//
+// Отображение страниц ОС для блоков строк больших матриц (см. LargePages()
+// в utmatrix.h). Системные заголовки подключаются только здесь.
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#include "utmatrix.h"
+
+void* PageAlloc(size_t& bytes) // bytes округляется до размера страницы
+{
+	bytes = (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+	void* p = 0;
+#ifdef _WIN32
+	if (LargePages() == LARGE_EXPLICIT && GetLargePageMinimum() != 0)
+		p = VirtualAlloc(0, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+	if (p == 0)
+		p = VirtualAlloc(0, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#ifdef MAP_HUGETLB
+	if (LargePages() == LARGE_EXPLICIT)
+	{
+		p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p == MAP_FAILED)
+			p = 0;
+	}
+#endif
+	if (p == 0)
+	{
+		p = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			p = 0;
+#ifdef MADV_HUGEPAGE
+		if (p != 0 && LargePages() != LARGE_LAZY)
+			madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+	}
+#endif
+	if (p == 0)
+		throw bad_alloc();
+	return p;
+} /*-------------------------------------------------------------------------*/
+
+void PageFree(void* p, size_t bytes)
+{
+#ifdef _WIN32
+	VirtualFree(p, 0, MEM_RELEASE);
+#else
+	munmap(p, bytes);
+#endif
+} /*-------------------------------------------------------------------------*/
@@ -0,0 +1,42 @@
+// Общие заготовки симметричных матриц и невязки U^T U для тестов
+// tsmatrix.h и построенных на нем разложений
+
+#ifndef __TEST_HELPERS_H__
+#define __TEST_HELPERS_H__
+
+#include "tsmatrix.h"
+
+#include <cmath>
+
+// симметричная матрица: 2 + i на диагонали, 1 / (i + j + 1) вне ее;
+// положительно определена (диагональное преобладание)
+inline void FillSym(TSymMatrix<double>& a)
+{
+	for (int i = 0; i < a.GetSize(); i++)
+		for (int j = i; j < a.GetSize(); j++)
+			a(i, j) = (i == j) ? 2.0 + i : 1.0 / (i + j + 1);
+}
+
+// (U^T U)[i][j], U - верхнетреугольная
+inline double UpperGram(const TMatrix<double>& u, int i, int j)
+{
+	double s = 0;
+	for (int k = 0; k <= i && k <= j; k++)
+		s += u.Row(k).Get_pVector()[i - k] * u.Row(k).Get_pVector()[j - k];
+	return s;
+}
+
+// max |(U^T U)[i][j] - A[i][j]|
+inline double GramResidual(const TSymMatrix<double>& a, const TMatrix<double>& u)
+{
+	double res = 0;
+	for (int i = 0; i < a.GetSize(); i++)
+		for (int j = i; j < a.GetSize(); j++)
+		{
+			const double d = fabs(UpperGram(u, i, j) - a(i, j));
+			res = (d > res) ? d : res;
+		}
+	return res;
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "tbmatrix.h"
+
+#include <gtest.h>
+
+// разреженное отношение, не кратное размеру слова
+static void Fill(TBitMatrix& m, int seed)
+{
+	for (int i = 0; i < m.GetSize(); i++)
+		for (int j = i; j < m.GetSize(); j++)
+			if ((i * 7 + j * 13 + seed) % 11 == 0)
+				m.Set(i, j);
+}
+
+TEST(TBitMatrix, can_create_matrix_with_positive_length)
+{
+	ASSERT_NO_THROW(TBitMatrix m(5));
+}
+
+TEST(TBitMatrix, throws_when_create_matrix_with_negative_length)
+{
+	ASSERT_ANY_THROW(TBitMatrix m(-5));
+}
+
+TEST(TBitMatrix, can_set_and_get_element)
+{
+	TBitMatrix m(200);
+	m.Set(70, 199);
+	m.Set(63, 64);
+	m.Set(5, 5);
+	EXPECT_TRUE(m(70, 199));
+	EXPECT_TRUE(m(63, 64));
+	EXPECT_TRUE(m(5, 5));
+	EXPECT_FALSE(m(70, 198));
+	EXPECT_FALSE(m(199, 70));
+	m.Set(70, 199, false);
+	EXPECT_FALSE(m(70, 199));
+	EXPECT_EQ(2, m.Count());
+}
+
+TEST(TBitMatrix, throws_when_set_element_below_diagonal)
+{
+	TBitMatrix m(4);
+	ASSERT_ANY_THROW(m.Set(2, 1));
+	ASSERT_ANY_THROW(m.Set(1, 4));
+}
+
+TEST(TBitMatrix, rows_of_different_length_do_not_overlap)
+{
+	const int size = 150;
+	TBitMatrix m(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			m.Set(i, j);
+	EXPECT_EQ(size * (size + 1) / 2, m.Count());
+	for (int i = 0; i < size; i++)
+		EXPECT_EQ(size - i, m.RowCount(i));
+}
+
+TEST(TBitMatrix, conversion_keeps_elements)
+{
+	const int size = 130;
+	TMatrix<int> a(size), b(0);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			a[i][j] = ((i + 2 * j) % 5 == 0) ? 3 : 0;
+	TBitMatrix m(a);
+	EXPECT_TRUE(m(0, 0));
+	EXPECT_FALSE(m(0, 1));
+	m.ToMatrix(b);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			EXPECT_EQ(a[i][j] != 0, b[i][j] == 1);
+	EXPECT_EQ(m, TBitMatrix(b));
+}
+
+TEST(TBitMatrix, logical_operations_are_elementwise)
+{
+	const int size = 140;
+	TBitMatrix a(size), b(size);
+	Fill(a, 0);
+	Fill(b, 3);
+	TBitMatrix c = a & b, d = a | b, e = a ^ b;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			EXPECT_EQ(a(i, j) && b(i, j), c(i, j));
+			EXPECT_EQ(a(i, j) || b(i, j), d(i, j));
+			EXPECT_EQ(a(i, j) != b(i, j), e(i, j));
+		}
+	EXPECT_EQ(0, (a ^ a).Count());
+}
+
+TEST(TBitMatrix, throws_when_combine_matrices_of_different_size)
+{
+	TBitMatrix a(4), b(5);
+	ASSERT_ANY_THROW(a | b);
+	ASSERT_ANY_THROW(a * b);
+}
+
+TEST(TBitMatrix, degree_counts_row_and_column)
+{
+	const int size = 100;
+	TBitMatrix m(size);
+	Fill(m, 1);
+	TVector<TIndex> deg = m.Degrees();
+	for (int v = 0; v < size; v++)
+	{
+		TIndex d = 0;
+		for (int u = 0; u < size; u++)
+			d += (u <= v) ? m(u, v) : m(v, u);
+		EXPECT_EQ(d, deg[v]);
+	}
+}
+
+TEST(TBitMatrix, product_is_equal_to_definition)
+{
+	const int size = 150;
+	TBitMatrix a(size), b(size);
+	Fill(a, 0);
+	Fill(b, 5);
+	TBitMatrix c = a * b;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			bool s = false;
+			for (int k = i; k <= j; k++)
+				s = s || (a(i, k) && b(k, j));
+			EXPECT_EQ(s, c(i, j));
+		}
+}
+
+TEST(TBitMatrix, closure_is_equal_to_warshall)
+{
+	const int size = 140;
+	TBitMatrix m(size);
+	Fill(m, 2);
+	bool r[size][size] = {};
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			r[i][j] = m(i, j);
+	for (int k = 0; k < size; k++)
+		for (int i = 0; i < size; i++)
+			for (int j = 0; j < size; j++)
+				r[i][j] = r[i][j] || (r[i][k] && r[k][j]);
+	TBitMatrix c = m.Closure();
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			EXPECT_EQ(r[i][j], c(i, j));
+	EXPECT_EQ(c, c.Closure());
+}
@@ -0,0 +1,87 @@
+#include "tcholesky.h"
+#include "test_helpers.h"
+
+#include <gtest.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+TEST(TCholesky, can_factor_small_matrix)
+{
+	TSymMatrix<double> a(2);
+	a(0, 0) = 4;
+	a(0, 1) = 2;
+	a(1, 1) = 5;
+	TMatrix<double> u = Cholesky(a);
+	EXPECT_EQ(2, u[0][0]);
+	EXPECT_EQ(1, u[0][1]);
+	EXPECT_EQ(2, u[1][1]);
+}
+
+TEST(TCholesky, blocked_factor_reproduces_matrix)
+{
+	const int size = 2 * CHOL_BLOCK + 13;
+	TSymMatrix<double> a(size);
+	FillSym(a);
+	TMatrix<double> u(0);
+	TCholeskyInfo info = CholeskyBlocked(a, u);
+	EXPECT_TRUE(info.Ok());
+	ASSERT_EQ(size, u.GetSize());
+	EXPECT_LT(GramResidual(a, u), 1e-12);
+}
+
+TEST(TCholesky, task_factor_is_equal_to_blocked_one)
+{
+	const int size = 3 * CHOL_BLOCK + 5;
+	TSymMatrix<double> a(size);
+	FillSym(a);
+	TMatrix<double> u(0), ut(0);
+	CholeskyBlocked(a, u);
+	EXPECT_TRUE(CholeskyTasks(a, ut).Ok());
+	EXPECT_TRUE(u.ApproxEqual(ut, 1e-13));
+}
+
+TEST(TCholesky, reports_first_nonpositive_pivot)
+{
+	const int size = CHOL_BLOCK + 10, bad = CHOL_BLOCK + 3;
+	TSymMatrix<double> a(size);
+	FillSym(a);
+	a(bad, bad) = -1;
+	TMatrix<double> u(0);
+	TCholeskyInfo info = CholeskyBlocked(a, u);
+	EXPECT_FALSE(info.Ok());
+	EXPECT_EQ(bad, info.Pivot);
+	EXPECT_LT(info.Value, 0);
+	EXPECT_EQ(bad, CholeskyTasks(a, u).Pivot);
+	ASSERT_ANY_THROW(Cholesky(a));
+}
+
+TEST(TCholesky, task_factor_of_indefinite_matrix_throws_with_several_threads)
+{
+	const int size = CHOL_TASK_MIN, bad = CHOL_TASK_MIN / 2 + 7;
+	TSymMatrix<double> a(size);
+	FillSym(a);
+	a(bad, bad) = -1;
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	omp_set_num_threads(4);
+#endif
+	TMatrix<double> u(0);
+	EXPECT_EQ(bad, CholeskyTasks(a, u).Pivot);
+	EXPECT_ANY_THROW(Cholesky(a));
+#ifdef _OPENMP
+	omp_set_num_threads(threads);
+#endif
+}
+
+TEST(TCholesky, factor_does_not_change_shared_matrix)
+{
+	CopyOnWrite() = true;
+	TSymMatrix<double> a(5);
+	FillSym(a);
+	TSymMatrix<double> a0(a);
+	TMatrix<double> u = Cholesky(a);
+	CopyOnWrite() = false;
+	EXPECT_EQ(a0, a);
+	EXPECT_LT(GramResidual(a, u), 1e-13);
+}
@@ -0,0 +1,95 @@
+#include "tcmatrix.h"
+
+#include <gtest.h>
+
+TEST(TCondensedMatrix, can_create_matrix_with_positive_length)
+{
+	ASSERT_NO_THROW(TCondensedMatrix<int> m(5));
+}
+
+TEST(TCondensedMatrix, throws_when_create_matrix_with_negative_length)
+{
+	ASSERT_ANY_THROW(TCondensedMatrix<int> m(-5));
+}
+
+TEST(TCondensedMatrix, size_is_limited_by_number_of_stored_elements)
+{
+	const TIndex saved = MaxVectorSize(), order = MaxMatrixSize();
+	MaxVectorSize() = 91; // 14 * 13 / 2
+	MaxMatrixSize() = 5;
+	EXPECT_NO_THROW(TCondensedMatrix<int> m(14));
+	EXPECT_ANY_THROW(TCondensedMatrix<int> m(15));
+	EXPECT_ANY_THROW(TCondensedMatrix<int> m(numeric_limits<TIndex>::max()));
+	MaxVectorSize() = saved;
+	MaxMatrixSize() = order;
+}
+
+TEST(TCondensedMatrix, index_enumerates_elements_above_diagonal_row_by_row)
+{
+	const int size = 9;
+	TIndex k = 0;
+	for (int i = 0; i < size; i++)
+		for (int j = i + 1; j < size; j++)
+			EXPECT_EQ(k++, TCondensedMatrix<int>::Index(size, i, j));
+	EXPECT_EQ(size * (size - 1) / 2, k);
+}
+
+TEST(TCondensedMatrix, can_set_and_get_element)
+{
+	TCondensedMatrix<int> m(4, 1);
+	m(1, 3) = 5;
+	const TCondensedMatrix<int>& c = m;
+	EXPECT_EQ(5, c(1, 3));
+	EXPECT_EQ(5, m.Row(1)[1]);
+	EXPECT_EQ(1, c(2, 2));
+	EXPECT_EQ(0, c(3, 1));
+}
+
+TEST(TCondensedMatrix, throws_when_set_element_on_or_below_diagonal)
+{
+	TCondensedMatrix<int> m(4);
+	ASSERT_ANY_THROW(m(2, 2) = 1);
+	ASSERT_ANY_THROW(m(3, 1) = 1);
+	ASSERT_ANY_THROW(m(1, 4) = 1);
+}
+
+TEST(TCondensedMatrix, conversion_to_matrix_keeps_elements_and_marks_diagonal)
+{
+	const int size = 7;
+	TMatrix<int> full(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i + 1; j < size; j++)
+			full[i][j] = i * 10 + j;
+	TCondensedMatrix<int> m(full);
+	EXPECT_EQ(3 * 10 + 5, m(3, 5));
+	TMatrix<int> back = m.ToMatrix();
+	EXPECT_EQ(full, back);
+	EXPECT_EQ(DIAG_ZERO, back.GetDiagonal());
+	EXPECT_EQ(DIAG_UNIT, TCondensedMatrix<int>(full, 1).ToMatrix().GetDiagonal());
+	EXPECT_EQ(m, TCondensedMatrix<int>(back));
+}
+
+TEST(TCondensedMatrix, can_multiply_by_vector)
+{
+	const int size = 100;
+	TCondensedMatrix<double> m(size, 2);
+	TVector<double> x(size), y(size);
+	for (int i = 0; i < size; i++)
+		x[i] = (i % 7) - 3.0;
+	for (int i = 0; i < size; i++)
+	{
+		y[i] = 2 * x[i];
+		for (int j = i + 1; j < size; j++)
+		{
+			m(i, j) = 1.0 / (i + j + 1);
+			y[i] += m(i, j) * x[j];
+		}
+	}
+	EXPECT_TRUE(MatVec(m, x).ApproxEqual(y, 1e-12));
+}
+
+TEST(TCondensedMatrix, throws_when_multiply_by_vector_of_wrong_size)
+{
+	TCondensedMatrix<double> m(4);
+	ASSERT_ANY_THROW(MatVec(m, TVector<double>(5)));
+}
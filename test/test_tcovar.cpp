@@ -0,0 +1,107 @@
+#include "tcovar.h"
+
+#include <gtest.h>
+
+// наблюдение k: большое среднее и небольшой разброс
+static TVector<double> Sample(int k, int size)
+{
+	TVector<double> x(size);
+	for (int j = 0; j < size; j++)
+		x[j] = 1e6 + j + ((k * (j + 3)) % 7) * 0.25 - 0.1 * (k % 3);
+	return x;
+}
+
+// ковариация по двухпроходной формуле
+static double Cov(int n, int size, int i, int j)
+{
+	double mi = 0, mj = 0, s = 0;
+	for (int k = 0; k < n; k++)
+	{
+		mi += Sample(k, size)[i];
+		mj += Sample(k, size)[j];
+	}
+	mi /= n;
+	mj /= n;
+	for (int k = 0; k < n; k++)
+		s += (Sample(k, size)[i] - mi) * (Sample(k, size)[j] - mj);
+	return s / (n - 1);
+}
+
+TEST(TCovariance, can_create_accumulator)
+{
+	TCovariance<double> c(5);
+	EXPECT_EQ(5, c.GetSize());
+	EXPECT_EQ(0, c.GetCount());
+	ASSERT_ANY_THROW(c.Covariance());
+}
+
+TEST(TCovariance, covariance_of_stream_is_equal_to_two_pass_one)
+{
+	const int size = 5, n = 2 * COV_BATCH + 7;
+	TCovariance<double> c(size);
+	for (int k = 0; k < n; k++)
+		c.Add(Sample(k, size));
+	EXPECT_EQ(n, c.GetCount());
+	TMatrix<double> cov = c.Covariance();
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			EXPECT_NEAR(Cov(n, size, i, j), cov[i][j], 1e-9);
+	EXPECT_NEAR(1e6 + 2, c.GetMean()[2], 1);
+}
+
+TEST(TCovariance, merged_accumulators_are_equal_to_one)
+{
+	const int size = 4, n = COV_BATCH + 50;
+	TCovariance<double> all(size), part[3] = { TCovariance<double>(size), TCovariance<double>(size), TCovariance<double>(size) };
+	for (int k = 0; k < n; k++)
+	{
+		all.Add(Sample(k, size));
+		part[k % 3 == 0 ? 0 : (k < n / 2 ? 1 : 2)].Add(Sample(k, size));
+	}
+	part[0].Merge(part[1]);
+	part[0].Merge(part[2]);
+	EXPECT_EQ(n, part[0].GetCount());
+	EXPECT_TRUE(all.Covariance().ApproxEqual(part[0].Covariance(), 1e-9));
+	EXPECT_TRUE(all.GetMean().ApproxEqual(part[0].GetMean(), 1e-9));
+}
+
+TEST(TCovariance, accumulator_can_be_merged_with_itself)
+{
+	const int size = 4, n = COV_BATCH + 50;
+	TCovariance<double> c(size), twice(size);
+	for (int k = 0; k < n; k++)
+	{
+		c.Add(Sample(k, size));
+		twice.Add(Sample(k, size));
+		twice.Add(Sample(k, size));
+	}
+	c.Merge(c);
+	EXPECT_EQ(2 * n, c.GetCount());
+	EXPECT_TRUE(twice.GetMean().ApproxEqual(c.GetMean(), 1e-9));
+	EXPECT_TRUE(twice.Covariance().ApproxEqual(c.Covariance(), 1e-6));
+}
+
+TEST(TCovariance, correlation_has_unit_diagonal)
+{
+	const int size = 3;
+	TCovariance<double> c(size);
+	for (int k = 0; k < 20; k++)
+	{
+		TVector<double> x(size);
+		x[0] = k;
+		x[1] = -2.0 * k + 1;
+		x[2] = 5;
+		c.Add(x);
+	}
+	TMatrix<double> r = c.Correlation();
+	EXPECT_NEAR(1, r[0][0], 1e-14);
+	EXPECT_NEAR(-1, r[0][1], 1e-14);
+	EXPECT_TRUE(r[2][2] != r[2][2]);
+}
+
+TEST(TCovariance, throws_when_sample_has_wrong_size)
+{
+	TCovariance<double> c(3);
+	ASSERT_ANY_THROW(c.Add(TVector<double>(4)));
+	ASSERT_ANY_THROW(c.Merge(TCovariance<double>(4)));
+}
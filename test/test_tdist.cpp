@@ -0,0 +1,90 @@
+#include "tdist.h"
+
+#include <gtest.h>
+
+// точки на разных расстояниях, не кратные размерам плиток
+static void Fill(TDenseMatrix<double>& x)
+{
+	for (int i = 0; i < x.GetRows(); i++)
+		for (int j = 0; j < x.GetCols(); j++)
+			x(i, j) = ((i * 13 + j * 7) % 17) * 0.5 - 3 + 0.01 * i;
+}
+
+// расстояние между точками i и j по определению
+static double Distance(const TDenseMatrix<double>& x, int i, int j, TDistance metric)
+{
+	double s = 0, xy = 0, xx = 0, yy = 0;
+	for (int k = 0; k < x.GetCols(); k++)
+	{
+		double t = x(i, k) - x(j, k);
+		s += (metric == DIST_MANHATTAN) ? fabs(t) : t * t;
+		xy += x(i, k) * x(j, k);
+		xx += x(i, k) * x(i, k);
+		yy += x(j, k) * x(j, k);
+	}
+	if (metric == DIST_COSINE)
+		return 1 - xy / sqrt(xx * yy);
+	return (metric == DIST_EUCLIDEAN) ? sqrt(s) : s;
+}
+
+TEST(TDistance, distances_are_equal_to_definitions)
+{
+	const int size = DIST_BLOCK + 21, dim = 11;
+	TDenseMatrix<double> x(size, dim);
+	Fill(x);
+	const TDistance metrics[4] = { DIST_EUCLIDEAN, DIST_SQEUCLIDEAN, DIST_COSINE, DIST_MANHATTAN };
+	for (int m = 0; m < 4; m++)
+	{
+		TMatrix<double> d = Distances(x, metrics[m]);
+		ASSERT_EQ(size, d.GetSize());
+		for (int i = 0; i < size; i++)
+		{
+			EXPECT_EQ(0, d[i][i]);
+			for (int j = i + 1; j < size; j++)
+				EXPECT_NEAR(Distance(x, i, j, metrics[m]), d[i][j], 1e-10);
+		}
+	}
+}
+
+TEST(TDistance, result_does_not_depend_on_storage_order)
+{
+	TDenseMatrix<double> x(30, 5), y(30, 5, COL_MAJOR);
+	Fill(x);
+	Fill(y);
+	EXPECT_EQ(Distances(x, DIST_MANHATTAN), Distances(y, DIST_MANHATTAN));
+	EXPECT_TRUE(Distances(x).ApproxEqual(Distances(y), 1e-12));
+}
+
+TEST(TDistance, euclidean_distance_of_equal_points_is_zero)
+{
+	TDenseMatrix<double> x(2, 3);
+	for (int k = 0; k < 3; k++)
+		x(0, k) = x(1, k) = 1e4 + 0.1 * k;
+	EXPECT_EQ(0, Distances(x)[0][1]);
+}
+
+TEST(TDistance, cosine_distance_of_zero_point_is_nan)
+{
+	TDenseMatrix<double> x(2, 3);
+	x(0, 0) = 1;
+	TMatrix<double> d = Distances(x, DIST_COSINE);
+	EXPECT_TRUE(d[0][1] != d[0][1]);
+	EXPECT_EQ(0, d[1][1]);
+}
+
+TEST(TDistance, condensed_distances_are_equal_to_full)
+{
+	const int size = DIST_BLOCK + 21, dim = 11;
+	TDenseMatrix<double> x(size, dim);
+	Fill(x);
+	const TDistance metrics[4] = { DIST_EUCLIDEAN, DIST_SQEUCLIDEAN, DIST_COSINE, DIST_MANHATTAN };
+	for (int m = 0; m < 4; m++)
+	{
+		TMatrix<double> d = Distances(x, metrics[m]);
+		EXPECT_EQ(DIAG_ZERO, d.GetDiagonal());
+		TCondensedMatrix<double> c(0);
+		Distances(x, c, metrics[m]);
+		ASSERT_EQ(size, c.GetSize());
+		EXPECT_EQ(TCondensedMatrix<double>(d), c);
+	}
+}
@@ -0,0 +1,140 @@
+#include "tdmatrix.h"
+
+#include <gtest.h>
+
+TEST(TDenseMatrix, can_create_matrix_with_positive_size)
+{
+	ASSERT_NO_THROW(TDenseMatrix<int> m(3, 5));
+}
+
+TEST(TDenseMatrix, throws_when_create_matrix_with_negative_size)
+{
+	ASSERT_ANY_THROW(TDenseMatrix<int> m(-3, 5));
+}
+
+TEST(TDenseMatrix, can_set_and_get_element)
+{
+	TDenseMatrix<int> m(3, 5, COL_MAJOR);
+	m(2, 4) = 7;
+	EXPECT_EQ(7, m(2, 4));
+}
+
+TEST(TDenseMatrix, throws_when_set_element_with_too_large_index)
+{
+	TDenseMatrix<int> m(3, 5);
+	ASSERT_ANY_THROW(m(3, 0) = 1);
+}
+
+TEST(TDenseMatrix, matrices_with_different_order_are_compared_by_elements)
+{
+	TDenseMatrix<int> a(2, 3), b(2, 3, COL_MAJOR);
+	for (int i = 0; i < 2; i++)
+		for (int j = 0; j < 3; j++)
+		{
+			a(i, j) = i * 3 + j;
+			b(i, j) = i * 3 + j;
+		}
+	EXPECT_EQ(a, b);
+}
+
+TEST(TDenseMatrix, can_multiply_triangular_by_dense)
+{
+	const int n = 3, m = 6;
+	TMatrix<int> u(n);
+	TDenseMatrix<int> b(n, m), res(n, m);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			u[i][j] = i + j + 1;
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			b(i, j) = i - j;
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			for (int k = i; k < n; k++)
+				res(i, j) += u[i][k] * b(k, j);
+	EXPECT_EQ(res, TRMM(u, b));
+}
+
+TEST(TDenseMatrix, can_multiply_transposed_dense_by_triangular)
+{
+	const int n = 4, m = 5;
+	TMatrix<int> u(n);
+	TDenseMatrix<int> b(n, m, COL_MAJOR), res(m, n);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			u[i][j] = 2 * i - j;
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			b(i, j) = i * j + 1;
+	for (int i = 0; i < m; i++)
+		for (int j = 0; j < n; j++)
+			for (int k = 0; k <= j; k++)
+				res(i, j) += b(k, i) * u[k][j];
+	EXPECT_EQ(res, TRMMTrans(b, u));
+}
+
+TEST(TDenseMatrix, cant_multiply_triangular_by_dense_with_not_equal_size)
+{
+	TMatrix<int> u(3);
+	TDenseMatrix<int> b(4, 2);
+	ASSERT_ANY_THROW(TRMM(u, b));
+}
+
+TEST(TDenseMatrix, solve_inverts_multiplication)
+{
+	const int n = 5, m = 7;
+	TMatrix<double> u(n);
+	TDenseMatrix<double> b(n, m);
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+			u[i][j] = (i == j) ? 2.0 : 1.0 / (i + j + 1);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			b(i, j) = i + 0.5 * j;
+	TDenseMatrix<double> x = TRSM(u, TRMM(u, b));
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			EXPECT_NEAR(b(i, j), x(i, j), 1e-12);
+}
+
+TEST(TDenseMatrix, throws_when_solve_with_singular_matrix)
+{
+	TMatrix<double> u(2);
+	TDenseMatrix<double> b(2, 2);
+	u[0][0] = 1;
+	ASSERT_ANY_THROW(TRSM(u, b));
+}
+
+TEST(TDenseMatrix, can_create_tall_matrix_with_more_rows_than_matrix_order_limit)
+{
+	ASSERT_NO_THROW(TDenseMatrix<double> m(MaxMatrixSize() * 2, 3));
+	ASSERT_ANY_THROW(TDenseMatrix<char> m(MaxVectorSize(), 2));
+}
+
+TEST(TDenseMatrix, kernels_follow_diagonal_flag)
+{
+	const int n = 6, m = 5;
+	TMatrix<double> u(n), z(n);
+	TDenseMatrix<double> b(n, m);
+	for (int i = 0; i < n; i++)
+		for (int j = i + 1; j < n; j++)
+			u[i][j] = z[i][j] = 1.0 / (i + j + 1);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			b(i, j) = i - 0.5 * j;
+	TMatrix<double> ref(u);
+	for (int i = 0; i < n; i++)
+		ref[i][i] = 1;
+	u.SetDiagonal(DIAG_UNIT); // хранимая диагональ та же, что у ref
+	EXPECT_EQ(TRMM(ref, b), TRMM(u, b));
+	EXPECT_EQ(TRMMTrans(b, ref), TRMMTrans(b, u));
+	TDenseMatrix<double> x = TRSM(u, TRMM(ref, b));
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < m; j++)
+			EXPECT_NEAR(b(i, j), x(i, j), 1e-12);
+	TMatrix<double> zs(z);
+	z.SetDiagonal(DIAG_ZERO);
+	EXPECT_EQ(TRMM(zs, b), TRMM(z, b));
+	EXPECT_EQ(TRMMTrans(b, zs), TRMMTrans(b, z));
+	ASSERT_ANY_THROW(TRSM(z, b));
+}
@@ -0,0 +1,163 @@
+#include "tlmatrix.h"
+
+#include <gtest.h>
+
+// верхнетреугольная матрица с ненулевой диагональю
+static void Fill(TMatrix<double>& m, int shift)
+{
+	for (int i = 0; i < m.GetSize(); i++)
+		for (int j = i; j < m.GetSize(); j++)
+			m[i][j] = (i == j) ? 2.0 + i : 1.0 / (i + j + shift);
+}
+
+TEST(TLowerMatrix, can_create_matrix_with_positive_length)
+{
+	ASSERT_NO_THROW(TLowerMatrix<int> m(5));
+}
+
+TEST(TLowerMatrix, can_set_and_get_element)
+{
+	TLowerMatrix<int> m(4);
+	m(3, 1) = 5;
+	EXPECT_EQ(5, m(3, 1));
+	EXPECT_EQ(0, ((const TLowerMatrix<int>&)m)(1, 3));
+}
+
+TEST(TLowerMatrix, throws_when_set_element_above_diagonal)
+{
+	TLowerMatrix<int> m(4);
+	ASSERT_ANY_THROW(m(1, 2) = 1);
+}
+
+TEST(TLowerMatrix, transpose_view_shares_storage)
+{
+	TMatrix<int> u(3);
+	u[0][2] = 7;
+	TTransposeView<int> l = Transpose(u);
+	EXPECT_EQ(7, l(2, 0));
+	EXPECT_EQ(0, l(0, 2));
+	u[0][2] = 8;
+	EXPECT_EQ(8, l(2, 0));
+	EXPECT_EQ(&u, &l.Upper());
+}
+
+TEST(TLowerMatrix, can_multiply_by_vector_in_both_orientations)
+{
+	const int size = 300;
+	TMatrix<double> u(size);
+	TVector<double> x(size), y(size), yt(size);
+	Fill(u, 1);
+	for (int i = 0; i < size; i++)
+		x[i] = (i % 5) - 2.0;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			y[i] += u[i][j] * x[j];
+			yt[j] += u[i][j] * x[i];
+		}
+	EXPECT_TRUE(MatVec(u, x).ApproxEqual(y, 1e-12));
+	EXPECT_TRUE(MatVec(Transpose(u), x).ApproxEqual(yt, 1e-12));
+	EXPECT_TRUE(MatVec(TLowerMatrix<double>(Transpose(u)), x).ApproxEqual(yt, 1e-12));
+}
+
+TEST(TLowerMatrix, can_solve_in_both_orientations)
+{
+	const int size = 20;
+	TMatrix<double> u(size);
+	TVector<double> x(size);
+	Fill(u, 3);
+	for (int i = 0; i < size; i++)
+		x[i] = i - 7.5;
+	EXPECT_TRUE(Solve(u, MatVec(u, x)).ApproxEqual(x, 1e-12));
+	EXPECT_TRUE(Solve(Transpose(u), MatVec(Transpose(u), x)).ApproxEqual(x, 1e-12));
+}
+
+TEST(TLowerMatrix, throws_when_solve_with_singular_matrix)
+{
+	TMatrix<double> u(3);
+	TVector<double> b(3);
+	ASSERT_ANY_THROW(Solve(Transpose(u), b));
+}
+
+TEST(TLowerMatrix, can_multiply_matrices_in_all_orientations)
+{
+	const int size = 6;
+	TMatrix<double> a(size), b(size);
+	Fill(a, 1);
+	Fill(b, 2);
+	TDenseMatrix<double> atb(size, size), abt(size, size);
+	TLowerMatrix<double> atbt(size);
+	for (int i = 0; i < size; i++)
+		for (int j = 0; j < size; j++)
+			for (int k = 0; k < size; k++)
+			{
+				double ta = Transpose(a)(i, k), tb = Transpose(b)(k, j);
+				atb(i, j) += ta * (k <= j ? b[k][j] : 0);
+				abt(i, j) += (k >= i ? a[i][k] : 0) * tb;
+				if (j <= i)
+					atbt(i, j) += ta * tb;
+			}
+	EXPECT_TRUE((Transpose(a) * Transpose(b)).Transposed().ApproxEqual(atbt.Transposed(), 1e-12));
+	TDenseMatrix<double> r1 = Transpose(a) * b, r2 = a * Transpose(b);
+	for (int i = 0; i < size; i++)
+		for (int j = 0; j < size; j++)
+		{
+			EXPECT_NEAR(atb(i, j), r1(i, j), 1e-12);
+			EXPECT_NEAR(abt(i, j), r2(i, j), 1e-12);
+		}
+}
+
+TEST(TLowerMatrix, can_grow_by_appending_rows)
+{
+	TLowerMatrix<int> l(0);
+	for (int n = 0; n < 5; n++)
+	{
+		TVector<int> r(n + 1);
+		for (int j = 0; j <= n; j++)
+			r[j] = n * 10 + j;
+		l.AppendRow(r);
+	}
+	EXPECT_EQ(5, l.GetSize());
+	EXPECT_EQ(42, l(4, 2));
+	EXPECT_EQ(0, ((const TLowerMatrix<int>&)l)(2, 4));
+}
+
+TEST(TLowerMatrix, multiply_and_solve_skip_unit_and_zero_diagonal)
+{
+	const int size = 300;
+	TMatrix<double> u(size);
+	TVector<double> x(size), y(size), yt(size), z(size), zt(size);
+	Fill(u, 1);
+	for (int i = 0; i < size; i++)
+		x[i] = (i % 5) - 2.0;
+	u.SetDiagonal(DIAG_UNIT);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			y[i] += u[i][j] * x[j];
+			yt[j] += u[i][j] * x[i];
+			if (j > i)
+			{
+				z[i] += u[i][j] * x[j];
+				zt[j] += u[i][j] * x[i];
+			}
+		}
+	EXPECT_TRUE(MatVec(u, x).ApproxEqual(y, 1e-12));
+	EXPECT_TRUE(MatVec(Transpose(u), x).ApproxEqual(yt, 1e-12));
+	EXPECT_TRUE(Solve(u, y).ApproxEqual(x, 1e-10));
+	EXPECT_TRUE(Solve(Transpose(u), yt).ApproxEqual(x, 1e-10));
+	u.SetDiagonal(DIAG_ZERO);
+	EXPECT_TRUE(MatVec(u, x).ApproxEqual(z, 1e-12));
+	EXPECT_TRUE(MatVec(Transpose(u), x).ApproxEqual(zt, 1e-12));
+	ASSERT_ANY_THROW(Solve(u, x));
+}
+
+TEST(TLowerMatrix, can_set_unit_diagonal)
+{
+	TLowerMatrix<int> l(3);
+	l(2, 0) = 4;
+	l.SetDiagonal(DIAG_UNIT);
+	EXPECT_EQ(DIAG_UNIT, l.GetDiagonal());
+	EXPECT_EQ(1, l(1, 1));
+	EXPECT_EQ(4, l(2, 0));
+}
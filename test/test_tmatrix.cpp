@@ -1,6 +1,7 @@
 #include "utmatrix.h"
 
 #include <gtest.h>
+#include <unordered_map>
 
 TEST(TMatrix, can_create_matrix_with_positive_length)
 {
@@ -108,6 +109,16 @@ TEST(TMatrix, compare_matrix_with_itself_return_true)
 	ASSERT_TRUE(m == m);
 }
 
+TEST(TMatrix, matrix_with_nan_is_not_equal_to_itself)
+{
+	TMatrix<double> m(3);
+	m[1][2] = numeric_limits<double>::quiet_NaN();
+	TMatrix<double> c(m);
+	EXPECT_FALSE(m == c);
+	EXPECT_FALSE(m == m);
+	EXPECT_TRUE(m != m);
+}
+
 TEST(TMatrix, matrices_with_different_size_are_not_equal)
 {
 	const int size = 2, size1 = 5;
@@ -171,3 +182,433 @@ TEST(TMatrix, cant_subtract_matrixes_with_not_equal_size)
 	ASSERT_ANY_THROW(m1 - m2);
 }
 
+
+TEST(TMatrix, can_get_norms)
+{
+	const int size = 3;
+	TMatrix<int> m(size);
+	// 1 -2  3
+	//    4 -5
+	//       6
+	m[0][0] = 1; m[0][1] = -2; m[0][2] = 3;
+	m[1][1] = 4; m[1][2] = -5;
+	m[2][2] = 6;
+	EXPECT_EQ(14, m.Norm1());
+	EXPECT_EQ(9, m.NormInf());
+	EXPECT_EQ(6, m.NormMax());
+	EXPECT_DOUBLE_EQ(sqrt(91.0), m.NormF());
+}
+
+TEST(TMatrix, can_get_sum_min_and_max)
+{
+	const int size = 40;
+	TMatrix<int> m(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			m[i][j] = i - j;
+	m[5][17] = 100;
+	int s = 0;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			s += m[i][j];
+	EXPECT_EQ(s, m.Sum());
+	EXPECT_EQ(100, m.Max());
+	EXPECT_EQ(1 - size, m.Min());
+}
+
+TEST(TMatrix, can_get_position_of_max_element)
+{
+	const int size = 20;
+	TMatrix<double> m(size);
+	TIndex i, j;
+	m[7][12] = 3.5;
+	m[9][9] = 3.5;
+	m.ArgMax(i, j);
+	EXPECT_EQ(7, i);
+	EXPECT_EQ(12, j);
+}
+
+TEST(TMatrix, throws_when_get_max_of_empty_matrix)
+{
+	TMatrix<int> m(0);
+	ASSERT_ANY_THROW(m.Max());
+}
+
+TEST(TMatrix, norm1_of_large_matrix_is_max_column_sum)
+{
+	const int size = 150;
+	TMatrix<int> m(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			m[i][j] = (i * 7 + j) % 11 - 5;
+	int res = 0;
+	for (int j = 0; j < size; j++)
+	{
+		int s = 0;
+		for (int i = 0; i <= j; i++)
+			s += abs(m[i][j]);
+		res = s > res ? s : res;
+	}
+	EXPECT_EQ(res, m.Norm1());
+}
+
+TEST(TMatrix, sum_is_same_in_both_reduce_modes)
+{
+	const int size = 50;
+	TMatrix<double> m(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			m[i][j] = i - j;
+	ReduceMode() = REDUCE_REPRODUCIBLE;
+	double repr = m.Sum();
+	ReduceMode() = REDUCE_FAST;
+	EXPECT_EQ(m.Sum(), repr);
+}
+
+TEST(TMatrix, can_compare_matrices_with_tolerance)
+{
+	const int size = 10;
+	TMatrix<double> m(size), m1(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			m[i][j] = i + j;
+			m1[i][j] = i + j + 1e-9;
+		}
+	EXPECT_TRUE(m != m1);
+	EXPECT_TRUE(m.ApproxEqual(m1, 1e-8));
+	m1[3][7] = 1;
+	EXPECT_FALSE(m.ApproxEqual(m1, 1e-8));
+}
+
+TEST(TMatrix, equal_matrices_have_equal_hashes)
+{
+	const int size = 30;
+	TMatrix<double> m(size), m1(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			m[i][j] = 1.0 / (i + j + 1);
+			m1[i][j] = 1.0 / (i + j + 1);
+		}
+	m[4][4] = 0.0;
+	m1[4][4] = -0.0;
+	EXPECT_EQ(m.Hash128(), m1.Hash128());
+	m1[29][29] += 1e-15;
+	EXPECT_NE(m.Hash(), m1.Hash());
+}
+
+TEST(TMatrix, hash_depends_on_size)
+{
+	TMatrix<int> m(2), m1(3);
+	EXPECT_NE(m.Hash(), m1.Hash());
+}
+
+TEST(TMatrix, hash_is_stable)
+{
+	TMatrix<int> m(3);
+	for (int i = 0; i < 3; i++)
+		for (int j = i; j < 3; j++)
+			m[i][j] = i * 3 + j;
+	EXPECT_EQ(0xA7D760DD135DCF0DULL, m.Hash());
+}
+
+TEST(TMatrix, can_be_key_of_unordered_map)
+{
+	unordered_map<TMatrix<int>, int> cache;
+	TMatrix<int> m(4), m1(4);
+	m1[1][2] = 5;
+	cache[m] = 1;
+	cache[m1] = 2;
+	EXPECT_EQ(2u, cache.size());
+	EXPECT_EQ(1, cache[TMatrix<int>(4)]);
+}
+
+TEST(TMatrix, can_multiply_matrices)
+{
+	const int size = 4;
+	TMatrix<int> m1(size), m2(size), res(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			m1[i][j] = i + j;
+			m2[i][j] = i - j + 1;
+		}
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			for (int k = i; k <= j; k++)
+				res[i][j] += m1[i][k] * m2[k][j];
+	EXPECT_EQ(res, m1 * m2);
+}
+
+TEST(TMatrix, cant_multiply_matrices_with_not_equal_size)
+{
+	TMatrix<int> m1(2), m2(3);
+	ASSERT_ANY_THROW(m1 * m2);
+}
+
+TEST(TMatrix, product_with_inverse_is_identity)
+{
+	const int size = 6;
+	TMatrix<double> m(size), e(size);
+	for (int i = 0; i < size; i++)
+	{
+		e[i][i] = 1;
+		for (int j = i; j < size; j++)
+			m[i][j] = (i == j) ? i + 1.0 : 1.0 / (j - i);
+	}
+	EXPECT_TRUE((m * m.Inverse()).ApproxEqual(e, 1e-12));
+}
+
+TEST(TMatrix, throws_when_invert_singular_matrix)
+{
+	TMatrix<double> m(3);
+	m[0][0] = m[2][2] = 1;
+	ASSERT_ANY_THROW(m.Inverse());
+}
+
+TEST(TMatrix, write_to_copy_detaches_only_changed_row)
+{
+	CopyOnWrite() = true;
+	TMatrix<int> m(40); // строки длиннее встроенного буфера
+	m[1][2] = 3;
+	TMatrix<int> m1(m);
+	CopyOnWrite() = false;
+	EXPECT_TRUE(m.IsShared());
+	m1[1][3] = 7;
+	EXPECT_EQ(0, m[1][3]);
+	EXPECT_EQ(3, m1[1][2]);
+	EXPECT_FALSE(m1.Row(1).IsShared());
+	EXPECT_TRUE(m1.Row(2).IsShared());
+}
+
+TEST(TMatrix, reading_shared_matrix_does_not_detach)
+{
+	CopyOnWrite() = true;
+	TMatrix<double> m(5);
+	TMatrix<double> m1(m);
+	CopyOnWrite() = false;
+	m1.NormF();
+	m1.Sum();
+	m1.Max();
+	EXPECT_TRUE(m1.IsShared());
+}
+
+TEST(TMatrix, padded_rows_have_aligned_columns)
+{
+	const int size = 13, w = ALIGN_BYTES / sizeof(double);
+	PadRows() = true;
+	TMatrix<double> m(size);
+	PadRows() = false;
+	for (int i = 0; i < size; i++)
+	{
+		EXPECT_TRUE(m.Row(i).IsPadded());
+		EXPECT_EQ(0u, (size_t)m.Row(i).Get_pBase() % ALIGN_BYTES);
+		EXPECT_EQ(0, (m.Row(i).GetExtent() + i - i % w) % w);
+		EXPECT_EQ((size_t)(i % w) * sizeof(double), (size_t)m.Row(i).Get_pVector() % ALIGN_BYTES);
+	}
+}
+
+TEST(TMatrix, padded_product_is_equal_to_packed_one)
+{
+	const int size = 21;
+	TMatrix<double> a(size), b(size);
+	PadRows() = true;
+	TMatrix<double> pa(size), pb(size);
+	PadRows() = false;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			a[i][j] = pa[i][j] = 1.0 / (i + j + 1);
+			b[i][j] = pb[i][j] = i - 0.25 * j;
+		}
+	PadRows() = true;
+	TMatrix<double> pc = pa * pb;
+	PadRows() = false;
+	TMatrix<double> c = a * b;
+	EXPECT_EQ(c, pc);
+	ReduceMode() = REDUCE_REPRODUCIBLE; // порядок сложения строк не зависит от потоков
+	EXPECT_EQ(c.NormF(), pc.NormF());
+	EXPECT_EQ(c.Sum(), pc.Sum());
+	ReduceMode() = REDUCE_FAST;
+	EXPECT_NEAR(c.NormF(), pc.NormF(), 1e-12 * c.NormF());
+	for (int i = 0; i < size; i++)
+	{
+		const TVector<double>& r = pc.Row(i);
+		const double* base = r.Get_pBase();
+		for (int j = 0; j < r.GetExtent(); j++)
+			if (base + j < r.Get_pVector() || base + j >= r.Get_pVector() + r.GetSize())
+			{
+				EXPECT_EQ(0, base[j]);
+			}
+	}
+}
+
+// Восстанавливает MaxMatrixSize() и LargePages() при выходе из теста,
+// в том числе после неудавшейся проверки ASSERT_*
+class TSettingsGuard
+{
+	TIndex size;
+	TLargePages mode;
+public:
+	TSettingsGuard() : size(MaxMatrixSize()), mode(LargePages()) {}
+	~TSettingsGuard() { MaxMatrixSize() = size; LargePages() = mode; }
+};
+
+TEST(TMatrix, large_matrix_rows_are_placed_in_one_page_block)
+{
+	const int size = 800; // больше LARGE_MIN_BYTES
+	TSettingsGuard guard;
+	LargePages() = LARGE_TRANSPARENT;
+	TMatrix<double> m(size);
+	for (int i = 0; i < size; i++)
+	{
+		EXPECT_TRUE(m.Row(i).IsPaged());
+		EXPECT_EQ(0u, (size_t)m.Row(i).Get_pVector() % ALIGN_BYTES);
+	}
+	EXPECT_EQ(0, m.Sum());
+	EXPECT_TRUE(m.Row(1).Get_pVector() > m.Row(0).Get_pVector());
+	EXPECT_FALSE(TMatrix<double>(10).Row(0).IsPaged());
+}
+
+TEST(TMatrix, paged_matrix_can_be_used_as_usual_one)
+{
+	const int size = 800;
+	TMatrix<double> a(size);
+	TSettingsGuard guard;
+	LargePages() = LARGE_EXPLICIT; // без выделенных больших страниц - как LARGE_TRANSPARENT
+	TMatrix<double> p(size);
+	LargePages() = LARGE_OFF;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j += 7)
+			a[i][j] = p[i][j] = 1.0 / (i + j + 1);
+	EXPECT_EQ(a, p);
+	EXPECT_EQ(a.NormF(), p.NormF());
+	TMatrix<double> c(p);
+	EXPECT_FALSE(c.Row(0).IsPaged());
+	EXPECT_EQ(a, c);
+	p[5] = TVector<double>(3, 5);
+	EXPECT_FALSE(p.Row(5).IsPaged());
+	EXPECT_TRUE(p.Row(6).IsPaged());
+}
+
+TEST(TMatrix, can_create_matrix_with_more_than_2_31_elements)
+{
+	if (sizeof(TIndex) < 8)
+	{
+		cout << "[  SKIPPED ] needs 64-bit TIndex (x64 build)" << endl;
+		return;
+	}
+	const TIndex size = 65537; // size * (size + 1) / 2 > 2^31
+	TSettingsGuard guard;
+	MaxMatrixSize() = size;
+	LargePages() = LARGE_LAZY; // страницы отображаются при обращении
+	TMatrix<char> m(size);
+	LargePages() = LARGE_OFF;
+	EXPECT_GT(size * (size + 1) / 2, (TIndex)numeric_limits<int>::max());
+	m[size - 2][size - 1] = 3;
+	m[40000][65000] = 5;
+	EXPECT_EQ(3, m[size - 2][size - 1]);
+	TIndex i, j;
+	m.ArgMax(i, j);
+	EXPECT_EQ(40000, i);
+	EXPECT_EQ(65000, j);
+}
+
+TEST(TMatrix, short_rows_use_inline_buffer)
+{
+	const int size = 40;
+	TMatrix<double> m(size);
+	for (int i = 0; i < size; i++)
+	{
+		EXPECT_EQ(size - i <= SmallCapacity<double>(), m.Row(i).IsSmall());
+		m[i][size - 1] = i;
+	}
+	TMatrix<double> c(m);
+	EXPECT_EQ(m, c);
+	TMatrix<double> p = m * c;
+	for (int i = 0; i < size; i++)
+		EXPECT_EQ(i * (size - 1.0), p[i][size - 1]);
+}
+
+TEST(TMatrix, can_grow_by_appending_columns)
+{
+	const int size = 30;
+	TMatrix<double> m(0), full(size);
+	for (int n = 0; n < size; n++)
+	{
+		TVector<double> c(n + 1);
+		for (int i = 0; i <= n; i++)
+			c[i] = full[i][n] = i * 100.0 + n;
+		m.AppendColumn(c);
+	}
+	EXPECT_EQ(size, m.GetSize());
+	EXPECT_EQ(full, m);
+	EXPECT_EQ(full * full, m * m);
+	m.ShrinkToFit();
+	EXPECT_EQ(size - 1, m.Row(1).GetCapacity());
+	EXPECT_EQ(full, m);
+}
+
+TEST(TMatrix, append_after_reserve_does_not_move_rows)
+{
+	TMatrix<int> m(2);
+	m.ReserveColumns(100);
+	const int* row0 = m.Row(0).Get_pVector();
+	for (int n = 2; n < 100; n++)
+		m.AppendColumn(TVector<int>(n + 1));
+	EXPECT_EQ(row0, m.Row(0).Get_pVector());
+	EXPECT_EQ(100, m.Row(0).GetSize());
+}
+
+TEST(TMatrix, throws_when_append_column_of_wrong_size)
+{
+	TMatrix<int> m(3);
+	ASSERT_ANY_THROW(m.AppendColumn(TVector<int>(3)));
+}
+
+TEST(TMatrix, set_diagonal_writes_diagonal_values)
+{
+	TMatrix<double> m(4);
+	for (int i = 0; i < 4; i++)
+		for (int j = i; j < 4; j++)
+			m[i][j] = i + j + 2.0;
+	m.SetDiagonal(DIAG_UNIT);
+	EXPECT_EQ(DIAG_UNIT, m.GetDiagonal());
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(1, m[i][i]);
+	m.SetDiagonal(DIAG_ZERO);
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(0, m[i][i]);
+	EXPECT_EQ(5, m[1][2]);
+	TMatrix<double> c(m);
+	EXPECT_EQ(DIAG_ZERO, c.GetDiagonal());
+}
+
+TEST(TMatrix, inverse_of_unit_triangular_matrix_is_unit_triangular)
+{
+	const int size = 40;
+	TMatrix<double> m(size), e(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i + 1; j < size; j++)
+			m[i][j] = 1.0 / (i + j + 1);
+	m.SetDiagonal(DIAG_UNIT);
+	for (int i = 0; i < size; i++)
+		e[i][i] = 1;
+	TMatrix<double> inv = m.Inverse();
+	EXPECT_EQ(DIAG_UNIT, inv.GetDiagonal());
+	EXPECT_TRUE((m * inv).ApproxEqual(e, 1e-12));
+	EXPECT_EQ(DIAG_UNIT, (m * inv).GetDiagonal());
+}
+
+TEST(TMatrix, append_column_keeps_known_diagonal)
+{
+	TMatrix<int> m(2);
+	m.SetDiagonal(DIAG_UNIT);
+	TVector<int> c(3);
+	c[0] = 4;
+	c[2] = 9;
+	m.AppendColumn(c);
+	EXPECT_EQ(4, m[0][2]);
+	EXPECT_EQ(1, m[2][2]);
+}
@@ -0,0 +1,100 @@
+#include "tmcache.h"
+
+#include <gtest.h>
+
+// установка кеша на время теста
+class TMatrixCacheTest : public ::testing::Test
+{
+protected:
+	TLruMatrixCache<double> cache;
+	TMatrix<double> a, b;
+
+	TMatrixCacheTest() : cache(1 << 20), a(20), b(20)
+	{
+		for (int i = 0; i < 20; i++)
+			for (int j = i; j < 20; j++)
+			{
+				a[i][j] = (i == j) ? 2.0 : 1.0 / (i + j + 1);
+				b[i][j] = i - 0.5 * j;
+			}
+	}
+	void SetUp() { TMatrixCache<double>::Active() = &cache; }
+	void TearDown() { TMatrixCache<double>::Active() = 0; }
+};
+
+TEST_F(TMatrixCacheTest, repeated_product_is_taken_from_cache)
+{
+	TMatrix<double> c1 = a * b;
+	TMatrix<double> c2 = a * b;
+	EXPECT_EQ(c1, c2);
+	EXPECT_EQ(1, cache.GetHits());
+	EXPECT_EQ(1, cache.GetMisses());
+	EXPECT_EQ(1u, cache.GetCount());
+}
+
+TEST_F(TMatrixCacheTest, different_operations_have_different_keys)
+{
+	TMatrix<double> c1 = a * b;
+	TMatrix<double> c2 = b * a;
+	TMatrix<double> c3 = a.Inverse();
+	EXPECT_EQ(0, cache.GetHits());
+	EXPECT_EQ(3u, cache.GetCount());
+	EXPECT_EQ(c3, a.Inverse());
+	EXPECT_EQ(1, cache.GetHits());
+}
+
+TEST_F(TMatrixCacheTest, changed_operand_is_not_found)
+{
+	TMatrix<double> c1 = a * b;
+	b[3][5] += 1;
+	TMatrix<double> c2 = a * b;
+	EXPECT_EQ(0, cache.GetHits());
+	EXPECT_NE(c1, c2);
+}
+
+TEST_F(TMatrixCacheTest, cache_keeps_byte_budget)
+{
+	TLruMatrixCache<double> small(9 * MatrixBytes(a)); // запись - два операнда и результат
+	TMatrixCache<double>::Active() = &small;
+	TMatrix<double> m(a);
+	for (int k = 0; k < 5; k++)
+	{
+		m[0][0] = k;
+		TMatrix<double> c = m * b;
+	}
+	EXPECT_EQ(3u, small.GetCount());
+	EXPECT_EQ(2, small.GetEvictions());
+	EXPECT_TRUE(small.GetBytes() <= small.GetBudget());
+	m[0][0] = 0;
+	TMatrix<double> c = m * b;
+	EXPECT_EQ(0, small.GetHits());
+	m[0][0] = 4;
+	c = m * b;
+	EXPECT_EQ(1, small.GetHits());
+}
+
+TEST_F(TMatrixCacheTest, hash_collision_is_a_miss)
+{
+	// запись с ключом операндов a, b, под которым ищутся другие операнды
+	TMatrixKey key(MATRIX_MUL, a.Hash128(), b.Hash128());
+	cache.Store(key, a, &b, a * b);
+	TMatrix<double> other(b), res(0);
+	other[0][0] += 1;
+	EXPECT_FALSE(cache.Find(key, a, &other, res));
+	EXPECT_EQ(1, cache.GetCollisions());
+	EXPECT_TRUE(cache.Find(key, a, &b, res));
+	EXPECT_EQ(a * b, res);
+}
+
+TEST_F(TMatrixCacheTest, diagonal_kind_is_part_of_key)
+{
+	TMatrix<double> u(a);
+	u.SetDiagonal(DIAG_UNIT);
+	TMatrix<double> s(u);
+	s.SetDiagonal(DIAG_STORED); // те же значения, другой вид диагонали
+	TMatrix<double> c1 = u.Inverse();
+	TMatrix<double> c2 = s.Inverse();
+	EXPECT_EQ(0, cache.GetHits());
+	EXPECT_EQ(DIAG_UNIT, c1.GetDiagonal());
+	EXPECT_EQ(DIAG_STORED, c2.GetDiagonal());
+}
@@ -0,0 +1,92 @@
+#include "tqr.h"
+#include "test_helpers.h"
+
+#include <gtest.h>
+
+// высокая матрица с полным рангом столбцов
+static void Fill(TDenseMatrix<double>& a)
+{
+	for (int i = 0; i < a.GetRows(); i++)
+		for (int j = 0; j < a.GetCols(); j++)
+			a(i, j) = ((i == j) ? 3.0 : 0.0) + 1.0 / (i + 2 * j + 1) - 0.01 * ((i * 7 + j * 3) % 11);
+}
+
+// max |(R^T R - A^T A)[i][j]|
+static double Residual(const TDenseMatrix<double>& a, const TMatrix<double>& r)
+{
+	const int n = a.GetCols();
+	double res = 0;
+	for (int i = 0; i < n; i++)
+		for (int j = i; j < n; j++)
+		{
+			double s = -UpperGram(r, i, j);
+			for (int k = 0; k < a.GetRows(); k++)
+				s += a(k, i) * a(k, j);
+			res = (fabs(s) > res) ? fabs(s) : res;
+		}
+	return res;
+}
+
+TEST(TQR, r_of_small_matrix_is_correct)
+{
+	TDenseMatrix<double> a(3, 2);
+	a(0, 0) = 3;
+	a(1, 0) = 4;
+	a(0, 1) = 1;
+	a(2, 1) = 2;
+	TMatrix<double> r = HouseholderQR(a);
+	EXPECT_NEAR(5, r[0][0], 1e-15);
+	EXPECT_NEAR(0.6, r[0][1], 1e-15);
+	EXPECT_NEAR(sqrt(5.0 - 0.36), r[1][1], 1e-15);
+}
+
+TEST(TQR, blocked_qr_reproduces_gram_matrix)
+{
+	const int rows = 150, cols = 2 * QR_BLOCK + 7;
+	TDenseMatrix<double> a(rows, cols);
+	Fill(a);
+	TMatrix<double> r = HouseholderQR(a);
+	ASSERT_EQ(cols, r.GetSize());
+	EXPECT_LT(Residual(a, r), 1e-11);
+	for (int i = 0; i < cols; i++)
+		EXPECT_GT(r[i][i], 0);
+}
+
+TEST(TQR, result_does_not_depend_on_storage_order)
+{
+	const int rows = 90, cols = QR_BLOCK + 3;
+	TDenseMatrix<double> a(rows, cols), b(rows, cols, COL_MAJOR);
+	Fill(a);
+	Fill(b);
+	EXPECT_TRUE(HouseholderQR(a).ApproxEqual(HouseholderQR(b), 1e-12));
+}
+
+TEST(TQR, in_place_qr_keeps_r_above_diagonal)
+{
+	TDenseMatrix<double> a(20, 5);
+	Fill(a);
+	TDenseMatrix<double> a0(a);
+	TMatrix<double> r(0);
+	HouseholderQR(a, r);
+	for (int j = 0; j < 5; j++)
+		EXPECT_NEAR(fabs(r[0][j]), fabs(a(0, j)), 1e-14);
+	EXPECT_TRUE(HouseholderQR(a0) == r);
+}
+
+TEST(TQR, tsqr_is_equal_to_householder_qr)
+{
+	const int rows = 700, cols = 40;
+	TDenseMatrix<double> a(rows, cols);
+	Fill(a);
+	TMatrix<double> r = HouseholderQR(a);
+	EXPECT_TRUE(r.ApproxEqual(TSQR(a, 100), 1e-11));
+	EXPECT_TRUE(r.ApproxEqual(TSQR(a), 1e-11));
+	EXPECT_TRUE(r.ApproxEqual(TSQR(a, 1), 1e-11));
+}
+
+TEST(TQR, throws_when_matrix_is_wide)
+{
+	TDenseMatrix<double> a(3, 4);
+	ASSERT_ANY_THROW(HouseholderQR(a));
+	ASSERT_ANY_THROW(TSQR(a));
+}
@@ -0,0 +1,88 @@
+#include "tqrupdate.h"
+
+#include <gtest.h>
+
+// R с положительной диагональю
+static void Fill(TMatrix<double>& r)
+{
+	for (int i = 0; i < r.GetSize(); i++)
+		for (int j = i; j < r.GetSize(); j++)
+			r[i][j] = (i == j) ? 2.0 + i : 1.0 / (i + j + 1);
+}
+
+// (R^T R)[i][j]
+static double Gram(const TMatrix<double>& r, int i, int j)
+{
+	double s = 0;
+	for (int k = 0; k <= i && k <= j; k++)
+		s += r.Row(k).Get_pVector()[i - k] * r.Row(k).Get_pVector()[j - k];
+	return s;
+}
+
+TEST(TQRUpdate, rank_one_update_adds_outer_product)
+{
+	const int size = 7;
+	TMatrix<double> r(size), r0(size);
+	Fill(r);
+	Fill(r0);
+	TVector<double> x(size);
+	for (int i = 0; i < size; i++)
+		x[i] = 0.5 * i - 1;
+	RankOneUpdate(r, x);
+	for (int i = 0; i < size; i++)
+	{
+		EXPECT_GT(r[i][i], 0);
+		for (int j = 0; j < size; j++)
+			EXPECT_NEAR(Gram(r0, i, j) + x[i] * x[j], Gram(r, i, j), 1e-12);
+	}
+}
+
+TEST(TQRUpdate, downdate_reverses_update)
+{
+	const int size = 9;
+	TMatrix<double> r(size), r0(size);
+	Fill(r);
+	Fill(r0);
+	TVector<double> x(size);
+	for (int i = 0; i < size; i++)
+		x[i] = 1.0 / (i + 1);
+	InsertRow(r, x);
+	DeleteRow(r, x);
+	EXPECT_TRUE(r.ApproxEqual(r0, 1e-12));
+}
+
+TEST(TQRUpdate, throws_when_downdate_is_not_positive_definite)
+{
+	TMatrix<double> r(3);
+	Fill(r);
+	TMatrix<double> r0(r);
+	TVector<double> x(3);
+	x[0] = 3;
+	ASSERT_ANY_THROW(RankOneDowndate(r, x));
+	EXPECT_EQ(r0, r);
+}
+
+TEST(TQRUpdate, throws_when_update_vector_has_wrong_size)
+{
+	TMatrix<double> r(3);
+	TVector<double> x(4);
+	ASSERT_ANY_THROW(RankOneUpdate(r, x));
+	ASSERT_ANY_THROW(RankOneDowndate(r, x));
+}
+
+TEST(TQRUpdate, delete_column_keeps_gram_of_other_columns)
+{
+	const int size = 6, k = 2;
+	TMatrix<double> r(size), r0(size);
+	Fill(r);
+	Fill(r0);
+	DeleteColumn(r, k);
+	ASSERT_EQ(size - 1, r.GetSize());
+	for (int i = 0; i < size - 1; i++)
+	{
+		EXPECT_GE(r[i][i], 0);
+		for (int j = 0; j < size - 1; j++)
+			EXPECT_NEAR(Gram(r0, i + (i >= k), j + (j >= k)), Gram(r, i, j), 1e-12);
+	}
+	ASSERT_ANY_THROW(DeleteColumn(r, size - 1));
+}
@@ -0,0 +1,160 @@
+#include "tsmatrix.h"
+#include "test_helpers.h"
+
+#include <gtest.h>
+
+TEST(TSymMatrix, can_create_matrix_with_positive_length)
+{
+	ASSERT_NO_THROW(TSymMatrix<int> m(5));
+}
+
+TEST(TSymMatrix, mirrored_elements_are_the_same)
+{
+	TSymMatrix<int> m(4);
+	m(3, 1) = 5;
+	EXPECT_EQ(5, m(1, 3));
+	EXPECT_EQ(5, m.Upper()[1][3]);
+	EXPECT_EQ(&m(1, 3), &m(3, 1));
+}
+
+TEST(TSymMatrix, throws_when_index_is_out_of_range)
+{
+	TSymMatrix<int> m(4);
+	ASSERT_ANY_THROW(m(4, 0));
+	ASSERT_ANY_THROW(m(0, -1));
+}
+
+TEST(TSymMatrix, can_create_from_dense_upper_triangle)
+{
+	TDenseMatrix<int> a(3, 3);
+	a(0, 2) = 7;
+	a(2, 0) = -1;
+	TSymMatrix<int> m(a);
+	EXPECT_EQ(7, m(2, 0));
+	ASSERT_ANY_THROW(TSymMatrix<int>(TDenseMatrix<int>(3, 4)));
+}
+
+TEST(TSymMatrix, can_add_and_subtract_matrices)
+{
+	TSymMatrix<int> a(3), b(3);
+	a(0, 1) = 2;
+	b(1, 0) = 3;
+	b(2, 2) = 1;
+	TSymMatrix<int> c = a + b, d = a - b;
+	EXPECT_EQ(5, c(1, 0));
+	EXPECT_EQ(1, c(2, 2));
+	EXPECT_EQ(-1, d(0, 1));
+	a += b;
+	EXPECT_EQ(c, a);
+	ASSERT_ANY_THROW(a += TSymMatrix<int>(4));
+}
+
+TEST(TSymMatrix, symv_is_equal_to_full_product)
+{
+	const int size = 37;
+	TSymMatrix<double> a(size);
+	FillSym(a);
+	TVector<double> x(size), res(size);
+	for (int i = 0; i < size; i++)
+		x[i] = i - 10.5;
+	for (int i = 0; i < size; i++)
+		for (int j = 0; j < size; j++)
+			res[i] += a(i, j) * x[j];
+	EXPECT_TRUE(res.ApproxEqual(MatVec(a, x), 1e-12));
+	ASSERT_ANY_THROW(MatVec(a, TVector<double>(size + 1)));
+}
+
+TEST(TSymMatrix, rank_k_update_adds_gram_matrix)
+{
+	const int size = 6, k = 4;
+	TSymMatrix<double> c(size), c0(size);
+	FillSym(c);
+	FillSym(c0);
+	TDenseMatrix<double> a(k, size), at(k, size, COL_MAJOR);
+	for (int r = 0; r < k; r++)
+		for (int j = 0; j < size; j++)
+			a(r, j) = at(r, j) = r - 0.5 * j;
+	TSymMatrix<double> ct(c);
+	RankKUpdate(c, a, 2.0);
+	RankKUpdate(ct, at, 2.0);
+	for (int i = 0; i < size; i++)
+		for (int j = 0; j < size; j++)
+		{
+			double s = c0(i, j);
+			for (int r = 0; r < k; r++)
+				s += 2.0 * a(r, i) * a(r, j);
+			EXPECT_NEAR(s, c(i, j), 1e-12);
+		}
+	EXPECT_EQ(c, ct);
+	ASSERT_ANY_THROW(RankKUpdate(c, TDenseMatrix<double>(k, size + 1)));
+}
+
+TEST(TSymMatrix, gram_matrix_is_equal_to_full_product)
+{
+	const int size = 2 * SYRK_NR + 3, k = SYRK_KC + 17;
+	TDenseMatrix<double> a(k, size), at(k, size, COL_MAJOR);
+	for (int r = 0; r < k; r++)
+		for (int j = 0; j < size; j++)
+			a(r, j) = at(r, j) = 1.0 / (r + j + 1) - 0.01 * j;
+	TMatrix<double> g = Gram(a);
+	ASSERT_EQ(size, g.GetSize());
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			double s = 0;
+			for (int r = 0; r < k; r++)
+				s += a(r, i) * a(r, j);
+			EXPECT_NEAR(s, g[i][j], 1e-12);
+		}
+	EXPECT_EQ(g, Gram(at));
+}
+
+TEST(TSymMatrix, gram_matrix_spanning_several_column_panels_is_correct)
+{
+	const int size = SYRK_NC + SYRK_MC + 5, k = 3;
+	TDenseMatrix<double> a(k, size);
+	for (int r = 0; r < k; r++)
+		for (int j = 0; j < size; j++)
+			a(r, j) = (r + 1) * 0.5 - 0.001 * j;
+	TMatrix<double> g = Gram(a);
+	int wrong = 0;
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			double s = 0;
+			for (int r = 0; r < k; r++)
+				s += a(r, i) * a(r, j);
+			wrong += fabs(s - g[i][j]) > 1e-12;
+		}
+	EXPECT_EQ(0, wrong);
+}
+
+TEST(TSymMatrix, syrk_scales_matrix_by_beta)
+{
+	TMatrix<double> c(3);
+	c[0][2] = 4;
+	TDenseMatrix<double> a(1, 3);
+	a(0, 0) = 1;
+	a(0, 2) = 2;
+	Syrk(c, a, 3.0, 0.5);
+	EXPECT_EQ(2 + 3 * 2, c[0][2]);
+	EXPECT_EQ(3, c[0][0]);
+	EXPECT_EQ(0, c[1][1]);
+	ASSERT_ANY_THROW(Syrk(c, TDenseMatrix<double>(1, 4)));
+}
+
+TEST(TSymMatrix, syrk_with_zero_beta_ignores_nan_in_result)
+{
+	const int size = 5;
+	TMatrix<double> c(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			c[i][j] = numeric_limits<double>::quiet_NaN();
+	TDenseMatrix<double> a(2, size);
+	for (int j = 0; j < size; j++)
+		a(0, j) = a(1, j) = j;
+	Syrk(c, a, 1.0, 0.0);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			EXPECT_EQ(2.0 * i * j, c[i][j]);
+}
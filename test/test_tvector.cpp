@@ -151,6 +151,14 @@ TEST(TVector, compare_vector_with_itself_return_true)
 	ASSERT_TRUE(v == v);
 }
 
+TEST(TVector, vector_with_nan_is_not_equal_to_itself)
+{
+	TVector<double> v(3);
+	v[1] = numeric_limits<double>::quiet_NaN();
+	EXPECT_FALSE(v == v);
+	EXPECT_TRUE(v != v);
+}
+
 TEST(TVector, vectors_with_different_size_are_not_equal)
 {
 	const int size = 2, size1 = 5;
@@ -266,3 +274,423 @@ TEST(TVector, cant_multiply_vectors_with_not_equal_size)
 	ASSERT_ANY_THROW(res = v * v1);
 }
 
+
+TEST(TVector, can_get_norms)
+{
+	const int size = 7;
+	TVector<int> v(size);
+	for (int i = 0; i < size; i++)
+		v[i] = (i % 2) ? -i : i;
+	EXPECT_EQ(21, v.NormL1());
+	EXPECT_EQ(6, v.NormInf());
+	EXPECT_DOUBLE_EQ(sqrt(91.0), v.NormL2());
+}
+
+TEST(TVector, norms_of_empty_vector_are_zero)
+{
+	TVector<double> v(0);
+	EXPECT_EQ(0, v.NormL1());
+	EXPECT_EQ(0, v.NormL2());
+	EXPECT_EQ(0, v.NormInf());
+}
+
+TEST(TVector, long_dot_product_is_same_in_both_reduce_modes)
+{
+	const int size = 3 * REDUCE_BLOCK + 17;
+	TVector<double> v(size), v1(size);
+	for (int i = 0; i < size; i++)
+	{
+		v[i] = i % 5;
+		v1[i] = (i % 3) - 1;
+	}
+	ReduceMode() = REDUCE_FAST;
+	double fast = v * v1;
+	ReduceMode() = REDUCE_REPRODUCIBLE;
+	double repr = v * v1;
+	ReduceMode() = REDUCE_FAST;
+	EXPECT_EQ(fast, repr);
+}
+
+TEST(TVector, can_get_norm_of_long_vector_in_reproducible_mode)
+{
+	const int size = 5 * REDUCE_BLOCK + 3;
+	TVector<double> v(size);
+	for (int i = 0; i < size; i++)
+		v[i] = (i % 2) ? -2.0 : 2.0;
+	ReduceMode() = REDUCE_REPRODUCIBLE;
+	double l1 = v.NormL1();
+	double l2 = v.NormL2();
+	ReduceMode() = REDUCE_FAST;
+	EXPECT_EQ(2.0 * size, l1);
+	EXPECT_DOUBLE_EQ(2.0 * sqrt((double)size), l2);
+}
+
+TEST(TVector, compensated_sum_keeps_small_terms)
+{
+	TVector<double> v(3);
+	v[0] = 1e16;
+	v[1] = 1.0;
+	v[2] = -1e16;
+	EXPECT_EQ(1.0, v.Sum(SUM_COMPENSATED));
+}
+
+TEST(TVector, compensated_dot_product_is_exact_for_rounded_products)
+{
+	const double e = ldexp(1.0, -30);
+	TVector<double> v(2), v1(2);
+	v[0] = 1 + e;
+	v1[0] = 1 - e;
+	v[1] = -1;
+	v1[1] = 1;
+	EXPECT_EQ(-e * e, v.Dot(v1, SUM_COMPENSATED));
+}
+
+TEST(TVector, compensated_dot_product_of_long_vectors)
+{
+	const int size = 3 * REDUCE_BLOCK + 5;
+	TVector<double> v(size), v1(size);
+	for (int i = 0; i < size; i++)
+	{
+		v[i] = 1.0;
+		v1[i] = 1.0;
+	}
+	v[0] = 1e16;
+	v[size - 1] = -1e16;
+	EXPECT_EQ(size - 2, v.Dot(v1, SUM_COMPENSATED));
+}
+
+TEST(TVector, cant_get_compensated_dot_product_of_vectors_with_not_equal_size)
+{
+	TVector<double> v(2), v1(3);
+	ASSERT_ANY_THROW(v.Dot(v1, SUM_COMPENSATED));
+}
+
+TEST(TVector, equal_vectors_of_doubles_are_compared_by_value)
+{
+	const int size = 200;
+	TVector<double> v(size), v1(size);
+	v[150] = 0.0;
+	v1[150] = -0.0;
+	EXPECT_TRUE(v == v1);
+	v1[199] = 1e-300;
+	EXPECT_TRUE(v != v1);
+}
+
+TEST(TVector, can_compare_vectors_with_tolerance)
+{
+	const int size = 100;
+	TVector<double> v(size), v1(size);
+	for (int i = 0; i < size; i++)
+	{
+		v[i] = 1000.0 * i;
+		v1[i] = v[i] * (1 + 1e-12);
+	}
+	EXPECT_FALSE(v.ApproxEqual(v1, 1e-12));
+	EXPECT_TRUE(v.ApproxEqual(v1, 1e-12, 1e-11));
+	EXPECT_FALSE(v.ApproxEqual(v1, 0, 1e-13));
+}
+
+TEST(TVector, can_compare_vectors_within_ulps)
+{
+	TVector<float> v(2), v1(2);
+	v[0] = 1.0f;
+	v1[0] = nextafterf(nextafterf(1.0f, 2.0f), 2.0f);
+	v[1] = nextafterf(0.0f, 1.0f);
+	v1[1] = -nextafterf(0.0f, 1.0f);
+	EXPECT_FALSE(v.ApproxEqual(v1, 0, 0, 1));
+	EXPECT_TRUE(v.ApproxEqual(v1, 0, 0, 2));
+}
+
+TEST(TVector, long_equal_vectors_have_equal_hashes)
+{
+	const int size = 2 * REDUCE_BLOCK + 7;
+	TVector<int> v(size), v1(size);
+	for (int i = 0; i < size; i++)
+		v[i] = v1[i] = i * i;
+	EXPECT_EQ(v.Hash128(), v1.Hash128());
+	v1[REDUCE_BLOCK + 1] = 0;
+	EXPECT_NE(v.Hash128(), v1.Hash128());
+}
+
+TEST(TVector, copy_shares_buffer_in_copy_on_write_mode)
+{
+	CopyOnWrite() = true;
+	TVector<int> v(50); // больше встроенного буфера
+	TVector<int> v1(v), v2(3);
+	v2 = v;
+	CopyOnWrite() = false;
+	const TVector<int>& cv = v;
+	EXPECT_TRUE(v.IsShared());
+	EXPECT_EQ(cv.Get_pVector(), ((const TVector<int>&)v1).Get_pVector());
+	EXPECT_EQ(cv.Get_pVector(), ((const TVector<int>&)v2).Get_pVector());
+}
+
+TEST(TVector, write_detaches_shared_buffer)
+{
+	CopyOnWrite() = true;
+	TVector<int> v(5);
+	for (int i = 0; i < 5; i++)
+		v[i] = i;
+	TVector<int> v1(v);
+	CopyOnWrite() = false;
+	v1[2] = 10;
+	EXPECT_EQ(2, v[2]);
+	EXPECT_EQ(10, v1[2]);
+	EXPECT_FALSE(v.IsShared());
+	EXPECT_FALSE(v1.IsShared());
+}
+
+TEST(TVector, copy_has_its_own_memory_without_copy_on_write)
+{
+	TVector<int> v(5);
+	TVector<int> v1(v);
+	EXPECT_FALSE(v.IsShared());
+	EXPECT_NE(((const TVector<int>&)v).Get_pVector(), ((const TVector<int>&)v1).Get_pVector());
+}
+
+TEST(TVector, buffer_is_aligned_to_cache_line)
+{
+	TVector<double> v(70, 3);
+	EXPECT_EQ(0u, (size_t)v.Get_pVector() % ALIGN_BYTES);
+	EXPECT_EQ(70, v.GetExtent());
+}
+
+TEST(TVector, padded_vector_has_zero_padding_and_same_norms)
+{
+	TVector<double> v(13, 3);
+	PadRows() = true;
+	TVector<double> p(13, 3);
+	PadRows() = false;
+	for (int i = 3; i < 16; i++)
+		v[i] = p[i] = i - 9.5;
+	EXPECT_TRUE(p.IsPadded());
+	EXPECT_EQ(16, p.GetExtent());
+	EXPECT_EQ(0u, (size_t)p.Get_pBase() % ALIGN_BYTES);
+	for (int i = 0; i < 3; i++)
+		EXPECT_EQ(0, p.Get_pBase()[i]);
+	EXPECT_EQ(v.Sum(), p.Sum());
+	EXPECT_EQ(v.NormL1(), p.NormL1());
+	EXPECT_EQ(v.NormInf(), p.NormInf());
+	EXPECT_EQ(v * v, p * p);
+	EXPECT_EQ(v, p);
+}
+
+TEST(TVector, can_use_start_index_above_2_31)
+{
+	if (sizeof(TIndex) < 8)
+	{
+		cout << "[  SKIPPED ] needs 64-bit TIndex (x64 build)" << endl;
+		return;
+	}
+	const TIndex si = (TIndex)numeric_limits<int>::max() + 10;
+	TVector<int> v(4, si);
+	v[si + 3] = 7;
+	EXPECT_EQ(si, v.GetStartIndex());
+	EXPECT_EQ(7, v[si + 3]);
+	ASSERT_ANY_THROW(v[si + 4]);
+}
+
+TEST(TVector, size_limit_can_be_changed)
+{
+	const TIndex saved = MaxVectorSize();
+	MaxVectorSize() = 100;
+	EXPECT_ANY_THROW(TVector<int> v(101));
+	MaxVectorSize() = saved;
+	ASSERT_NO_THROW(TVector<int> v(101));
+}
+
+TEST(TVector, short_vector_uses_inline_buffer)
+{
+	TVector<double> v(SmallCapacity<double>(), 2), w(SmallCapacity<double>() + 1);
+	EXPECT_TRUE(v.IsSmall());
+	EXPECT_FALSE(w.IsSmall());
+	EXPECT_FALSE(TVector<TVector<int> >(1).IsSmall());
+}
+
+TEST(TVector, copy_of_short_vector_has_its_own_inline_buffer)
+{
+	if (SmallCapacity<int>() < 3) // встроенный буфер отключен при сборке
+		return;
+	CopyOnWrite() = true;
+	TVector<int> v(3);
+	v[1] = 5;
+	TVector<int> v1(v), v2(40);
+	v2 = v;
+	CopyOnWrite() = false;
+	EXPECT_TRUE(v1.IsSmall());
+	EXPECT_FALSE(v2.IsShared()); // присваивание использует емкость v2
+	EXPECT_FALSE(v.IsShared());
+	v1[1] = 6;
+	EXPECT_EQ(5, v[1]);
+	EXPECT_EQ(5, v2[1]);
+	EXPECT_EQ(6, v1[1]);
+}
+
+TEST(TVector, push_back_grows_capacity_geometrically)
+{
+	TVector<double> v(0);
+	int reallocs = 0;
+	const double* p = v.Get_pVector();
+	for (int i = 0; i < 1000; i++)
+	{
+		v.PushBack(i);
+		if (v.Get_pVector() != p)
+		{
+			reallocs++;
+			p = v.Get_pVector();
+		}
+	}
+	EXPECT_EQ(1000, v.GetSize());
+	EXPECT_GE(v.GetCapacity(), 1000);
+	EXPECT_LE(reallocs, 12);
+	EXPECT_EQ(999 * 1000 / 2, v.Sum());
+	EXPECT_EQ(500, v[500]);
+}
+
+TEST(TVector, push_back_of_own_element_is_correct)
+{
+	TVector<int> v(0);
+	v.PushBack(7);
+	for (int i = 0; i < 20; i++)
+		v.PushBack(v[0]);
+	EXPECT_EQ(21, v.GetSize());
+	EXPECT_EQ(21 * 7, v.Sum());
+}
+
+TEST(TVector, can_reserve_resize_and_shrink)
+{
+	TVector<int> v(3);
+	v[2] = 5;
+	v.Reserve(100);
+	EXPECT_GE(v.GetCapacity(), 100);
+	EXPECT_EQ(3, v.GetSize());
+	v.Resize(50);
+	EXPECT_EQ(5, v[2]);
+	EXPECT_EQ(0, v[49]);
+	v.Resize(2);
+	v.Resize(3);
+	EXPECT_EQ(0, v[2]);
+	v.ShrinkToFit();
+	EXPECT_TRUE(v.IsSmall());
+	EXPECT_EQ(3, v.GetSize());
+	v.PopBack();
+	EXPECT_EQ(2, v.GetSize());
+	ASSERT_ANY_THROW(TVector<int>(0).PopBack());
+}
+
+TEST(TVector, emplace_back_returns_new_element)
+{
+	TVector<double> v(0, 3);
+	double& x = v.EmplaceBack(2.5);
+	EXPECT_EQ(2.5, x);
+	EXPECT_EQ(2.5, v[3]);
+}
+
+TEST(TVector, emplace_back_of_own_element_at_capacity_is_correct)
+{
+	TVector<TVector<int> > v(0);
+	v.EmplaceBack(TVector<int>(50, 0));
+	v[0][10] = 7;
+	while (v.GetSize() < v.GetCapacity())
+		v.EmplaceBack(5);
+	const TIndex n = v.GetSize();
+	v.EmplaceBack(v[0]); // буфер перераспределяется
+	EXPECT_EQ(n + 1, v.GetSize());
+	EXPECT_EQ(v[0], v[n]);
+	EXPECT_EQ(7, v[n][10]);
+}
+
+// элемент неарифметического типа, считающий живые объекты
+struct TCounted
+{
+	static int Live, Defaults;
+	int V;
+	TCounted() : V(0) { Live++; Defaults++; }
+	TCounted(int v) : V(v) { Live++; }
+	TCounted(const TCounted& c) : V(c.V) { Live++; }
+	~TCounted() { Live--; }
+	TCounted& operator=(const TCounted& c) { V = c.V; return *this; }
+};
+int TCounted::Live = 0, TCounted::Defaults = 0;
+
+TEST(TVector, growth_constructs_and_destroys_only_live_elements)
+{
+	TCounted::Live = TCounted::Defaults = 0;
+	{
+		TVector<TCounted> v(0);
+		for (int i = 0; i < 100; i++)
+			v.PushBack(TCounted(i));
+		EXPECT_EQ(0, TCounted::Defaults); // перенос не создает пустых элементов
+		EXPECT_EQ(100, TCounted::Live);
+		v.PopBack();
+		v.Reserve(1000);
+		v.EmplaceBack(7);
+		EXPECT_EQ(100, TCounted::Live);
+		EXPECT_EQ(98, v[98].V);
+		EXPECT_EQ(7, v[99].V);
+		v.Resize(10);
+		EXPECT_EQ(10, TCounted::Live);
+	}
+	EXPECT_EQ(0, TCounted::Live);
+}
+
+TEST(TVector, growth_keeps_padding_zero)
+{
+	PadRows() = true;
+	TVector<double> v(5, 3);
+	PadRows() = false;
+	for (int i = 0; i < 30; i++)
+		v.PushBack(1);
+	EXPECT_TRUE(v.IsPadded());
+	v.Resize(9); // 5 нулей и 4 единицы, остальное - нулевое дополнение
+	EXPECT_EQ(4, v.Sum());
+	EXPECT_EQ(4, v.NormL1());
+}
+
+TEST(TVector, growth_of_shared_vector_does_not_change_copy)
+{
+	CopyOnWrite() = true;
+	TVector<int> v(40);
+	TVector<int> c(v);
+	CopyOnWrite() = false;
+	v.PushBack(1);
+	EXPECT_EQ(40, c.GetSize());
+	EXPECT_EQ(41, v.GetSize());
+	EXPECT_EQ(1, v[40]);
+}
+
+TEST(TVector, move_takes_buffer)
+{
+	TVector<int> v(100);
+	v[5] = 3;
+	const int* p = ((const TVector<int>&)v).Get_pVector();
+	TVector<int> m(std::move(v));
+	EXPECT_EQ(p, ((const TVector<int>&)m).Get_pVector());
+	EXPECT_EQ(3, m[5]);
+	EXPECT_EQ(0, v.GetSize());
+	TVector<int> s(2);
+	s[1] = 4;
+	m = std::move(s);
+	EXPECT_EQ(4, m[1]);
+	EXPECT_TRUE(m.IsSmall());
+}
+
+TEST(TVector, dot_operator_and_dot_method_agree_for_padded_vectors)
+{
+	const int size = 10000, start = 3;
+	PadRows() = true;
+	TVector<double> pa(size, start), pb(size, start);
+	PadRows() = false;
+	TVector<double> a(size, start), b(size, start);
+	for (int i = start; i < size + start; i++)
+	{
+		a[i] = pa[i] = 1.0 / i;
+		b[i] = pb[i] = i % 7 - 3.1;
+	}
+	ReduceMode() = REDUCE_REPRODUCIBLE;
+	const double d = a.Dot(b);
+	EXPECT_EQ(d, a * b);
+	EXPECT_EQ(d, pa * pb);
+	EXPECT_EQ(d, pa.Dot(pb));
+	ReduceMode() = REDUCE_FAST;
+}
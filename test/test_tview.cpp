@@ -0,0 +1,158 @@
+#include "tview.h"
+
+#include <gtest.h>
+
+TEST(TVectorSpan, can_create_span_of_vector_part)
+{
+	TVector<int> v(10, 2);
+	for (int i = 2; i < 12; i++)
+		v[i] = i;
+	TVectorSpan<int> s = Span(v, 4, 3);
+	EXPECT_EQ(3, s.GetSize());
+	EXPECT_EQ(4, s[0]);
+	EXPECT_EQ(6, s[2]);
+}
+
+TEST(TVectorSpan, throws_when_span_is_out_of_vector)
+{
+	TVector<int> v(10);
+	ASSERT_ANY_THROW(Span(v, 8, 3));
+	ASSERT_ANY_THROW(Span(v, -1, 3));
+}
+
+TEST(TVectorSpan, write_through_strided_span_changes_vector)
+{
+	TVector<int> v(10);
+	TVectorSpan<int> s = Span(v, 1, 5, 2);
+	for (int i = 0; i < s.GetSize(); i++)
+		s[i] = 1;
+	EXPECT_EQ(5, v.Sum());
+	EXPECT_EQ(1, v[9]);
+	EXPECT_EQ(0, v[8]);
+}
+
+TEST(TVectorSpan, can_compute_dot_and_norms_of_spans)
+{
+	TVector<double> v(8);
+	for (int i = 0; i < 8; i++)
+		v[i] = i - 3;
+	const TVector<double>& cv = v;
+	TVectorSpan<const double> even = Span(cv, 0, 4, 2), odd = Span(cv, 1, 4, 2);
+	EXPECT_EQ(-3 * -2 + -1 * 0 + 1 * 2 + 3 * 4, Dot(even, odd));
+	EXPECT_EQ(8, NormL1(even));
+	EXPECT_EQ(4, NormInf(odd));
+	EXPECT_EQ(4, Sum(Span(cv)));
+	EXPECT_DOUBLE_EQ(sqrt(20.0), NormL2(even));
+}
+
+TEST(TVectorSpan, can_add_scaled_span)
+{
+	TVector<int> x(4), y(4);
+	for (int i = 0; i < 4; i++)
+	{
+		x[i] = i;
+		y[i] = 1;
+	}
+	Axpy(2, Span((const TVector<int>&)x), Span(y));
+	EXPECT_EQ(7, y[3]);
+	Scale(Span(y, 0, 2), 3);
+	EXPECT_EQ(9, y[1]);
+}
+
+TEST(TVectorSpan, axpy_of_overlapping_spans_is_done_in_order)
+{
+	const int size = 40;
+	TVector<double> v(size), ref(size);
+	for (int i = 0; i < size; i++)
+		v[i] = ref[i] = i % 7;
+	Axpy(0.5, Span(v, 3, 30), Span(v, 0, 30)); // x правее y
+	for (int i = 0; i < 30; i++)
+		ref[i] += 0.5 * ref[i + 3];
+	EXPECT_EQ(ref, v);
+	Axpy(2.0, Span(v, 0, 30), Span(v, 5, 30)); // x левее y
+	for (int i = 0; i < 30; i++)
+		ref[i + 5] += 2.0 * ref[i];
+	EXPECT_EQ(ref, v);
+}
+
+TEST(TVectorSpan, can_work_with_matrix_rows_and_columns)
+{
+	const int size = 4;
+	TMatrix<int> m(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			m[i][j] = i * 10 + j;
+	TVectorSpan<int> r = RowSpan(m, 1);
+	EXPECT_EQ(3, r.GetSize());
+	EXPECT_EQ(11, r[0]);
+	r[2] = 0;
+	EXPECT_EQ(0, m[1][3]);
+	TColumnView<int> c(m, 2);
+	EXPECT_EQ(3, c.GetSize());
+	EXPECT_EQ(12, c[1]);
+	TVector<int> ones(3);
+	for (int i = 0; i < 3; i++)
+		ones[i] = 1;
+	EXPECT_EQ(2 + 12 + 22, Dot(c, Span(ones)));
+}
+
+TEST(TBlockView, can_get_elements_of_blocks)
+{
+	const int size = 6;
+	TMatrix<int> m(size);
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+			m[i][j] = i * 10 + j;
+	TBlockView<int> tri = TriBlock(m, 2, 5), rect = Block(m, 0, 2, 3, 6);
+	EXPECT_EQ(22, tri.Get(0, 0));
+	EXPECT_EQ(0, tri.Get(2, 1));
+	EXPECT_EQ(34, tri.Get(1, 2));
+	EXPECT_EQ(1, tri.Row(2).GetSize());
+	EXPECT_EQ(15, rect.Get(1, 2));
+	EXPECT_EQ(3, rect.Row(0).GetSize());
+	rect.Row(1)[0] = -1;
+	EXPECT_EQ(-1, m[1][3]);
+}
+
+TEST(TBlockView, blocked_matvec_is_equal_to_full_one)
+{
+	const int size = 7, nb = 3;
+	TMatrix<double> m(size);
+	TVector<double> x(size), y(size), yt(size), res(size), rest(size);
+	for (int i = 0; i < size; i++)
+	{
+		x[i] = i + 1;
+		for (int j = i; j < size; j++)
+			m[i][j] = 1.0 / (i + j + 1);
+	}
+	for (int i = 0; i < size; i++)
+		for (int j = i; j < size; j++)
+		{
+			res[i] += m[i][j] * x[j];
+			rest[j] += m[i][j] * x[i];
+		}
+	const TMatrix<double>& cm = m;
+	for (int r = 0; r < size; r += nb)
+		for (int c = r; c < size; c += nb)
+		{
+			int r1 = (r + nb < size) ? r + nb : size, c1 = (c + nb < size) ? c + nb : size;
+			TBlockView<const double> b = Block(cm, r, r1, c, c1);
+			MatVec(b, Span(x, c, c1 - c), Span(y, r, r1 - r));
+			MatTVec(b, Span(x, r, r1 - r), Span(yt, c, c1 - c));
+		}
+	EXPECT_TRUE(res.ApproxEqual(y, 1e-14));
+	EXPECT_TRUE(rest.ApproxEqual(yt, 1e-14));
+}
+
+TEST(TBlockView, const_views_do_not_detach_shared_rows)
+{
+	CopyOnWrite() = true;
+	TMatrix<double> m(5);
+	TMatrix<double> m1(m);
+	CopyOnWrite() = false;
+	const TMatrix<double>& cm1 = m1;
+	TBlockView<const double> b = TriBlock(cm1, 1, 4);
+	EXPECT_EQ(0, b.Get(0, 2));
+	EXPECT_EQ(0, Sum(RowSpan(cm1, 2)));
+	EXPECT_TRUE(m1.IsShared());
+}